@@ -77,6 +77,34 @@ For the generator see mrmEvgSetupVME() or the ::evgMrm class.
 
 @section changelog Changelog
 
+@subsection devel Unreleased
+
+@li EVR: optional decoupling of FIFO reading and event dispatch through a lock-free ring.  See var("mrmEvrFIFORing")
+@li EVR: FIFO status is sampled once per batch instead of once per event.  Add bus read counters.
+@li EVR: adaptive FIFO holdoff replaces the fixed mrmEvrFIFOPeriod sleep, which now sets the default maximum.
+@li EVR: optional per event code latency histograms.  See mrmEvrLatencyReport()
+@li EVR: mrmEvrEventWorker() runs the I/O Intr scans of chosen event codes in a dedicated thread (Base >= 3.16.1)
+@li Data buffer Rx: receivers may retain buffers (dataBufRxRef).  The waveform device support may copy from a retained buffer via scanOnce() instead of in the Rx callback (link option Defer=1).
+@li Data buffer Rx: listeners may register for one Protocol ID, and are found through a table instead of a list.  Add per Protocol ID counters.
+@li EVR: data buffer Rx pool depth and buffer size are set with var("mrmEvrBufRxDepth") and var("mrmEvrBufRxSize"), and may grow on demand up to var("mrmEvrBufRxMaxDepth").  Add pool usage PVs.
+@li Data buffer Tx: add dataSendAsync().  MRM cards queue buffers to a worker thread, and the Tx waveform device support now completes asynchronously.
+@li Soft sequences may be double buffered across two HW sequencers ($(P)DoubleBuf-Sel).  Commit then writes the idle sequencer from thread context and swaps at end of sequence.
+@li Object properties: findProperty() returns properties bound once per instance.  Device support no longer allocates a property per record, and lookup no longer builds std::string keys.
+@li Parallel card setup.  With var("mrfSetupThreads") >0, mrmEvrSetup*() and mrmEvgSetup*() probe the bus and queue the remaining initialization, which runs concurrently at the start of iocInit() (or on mrfSetupWait()), followed by a per card timing report.
+@li EVR timestamp capture buffers convert ticks with integer fixed point arithmetic.  32-bit elements now saturate instead of wrapping, and waveforms with FTVL=INT64 (Base >=3.16) get 64-bit nanoseconds.
+@li EVR timestamp capture buffers have an optional continuous capture ring (mrmevrtsring.db).  It can hold millions of entries and may be backed by a memory mapped file.  Each reader gets the entries since its last read, and overwritten entries are counted.
+@li EVR: optionally serve the current time by extrapolating from the time latched at each seconds tick with the CPU monotonic clock (Base >=3.16.1).  See var("evrMrmTimeExtrapolate") and var("evrMrmTimeExtrapolateMaxNS").
+@li EVR: the time of the last occurrence of each event code is published with a sequence lock.  getTimeStamp() for an event code reads it without waiting for the FIFO drain loop.
+@li EVR: timestamp tick to nanosecond conversion uses a cached fixed point factor, updated when the clock or timestamp source changes.
+@li EVR: mapping RAM is kept as an image in host memory.  The initial configuration is written in one pass, into the inactive RAM followed by a switch, once the IOC is running.  See mrmEvrMapDefer() and evrMrmMapBankSwitch.
+@li IRQPoller honours its period, and can busy-poll on a chosen CPU.  PCI EVRs and EVGs set up with mrfIRQPoll=1 are polled instead of using their interrupt (see mrfIRQPollPeriod and mrfIRQPollCPU).  Poll count and mean loop time are shown by dbior, and by the $(P)Cnt:IRQPoll-I and $(P)IRQPollLoop-I records.
+@li Add mrmEvrSetupSim() and mrmEvgSetupSim() to simulate an EVR or EVG, including their software triggered sequencers, without hardware.  Requires a build with MRF_SIM_IO=YES.  The simulated EVG only runs its sequencers.
+@li Configuration registers of EVR and EVG subunits are read from a host copy.  mrfShadowVerify() compares it with the card, and can re-write.
+@li Add mrf::RegBatch to queue register writes and perform them together.  Used by the delay module and CML pattern updates.
+@li Seq Merge uses a heap based k-way merge, O(N log K) instead of O(N K).  Also available to C++ code as seqMerge() (seqmerge.h).  Trailing code 0 elements no longer cause an overflow error.
+@li Soft sequence commit writes only those sequence RAM words which have changed.  The count is shown as $(P)NumOfRAMWrites-I.
+@li Soft sequences may be longer than 2048 entries and 2^32 ticks.  Times are split with HW counter rollover entries.  With double buffering, RAM sized segments are streamed through the second HW sequencer, which is refilled from a callback thread.  Each following segment starts from the end of sequence interrupt, so is delayed by the interrupt latency.
+
 @subsection v221 2.3.0 (Apr 2020)
 
 @li Add support for mTCA-EVM-300
@@ -77,6 +77,8 @@ OBJECT_BEGIN(evgMrm) {
     OBJECT_PROP2("FracSynFreq", &evgMrm::getFracSynFreq, &evgMrm::setFracSynFreq);
     OBJECT_PROP1("Frequency",   &evgMrm::getFrequency);
     OBJECT_PROP1("PLL Lock Status", &evgMrm::pllLocked);
+    OBJECT_PROP1("IRQ Poll Count", &evgMrm::irqPollCount);
+    OBJECT_PROP1("IRQ Poll Loop Time", &evgMrm::irqPollLoopTime);
 } OBJECT_END(evgMrm)
 
 
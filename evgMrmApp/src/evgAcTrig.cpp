@@ -15,9 +15,9 @@
 
 #include "evgRegMap.h"
 
-evgAcTrig::evgAcTrig(const std::string& name, volatile epicsUInt8* const pReg):
+evgAcTrig::evgAcTrig(const std::string& name, mrf::RegShadow& shadow):
 mrf::ObjectInst<evgAcTrig>(name),
-m_pReg(pReg) {
+m_shadow(shadow) {
 }
 
 evgAcTrig::~evgAcTrig() {
@@ -28,13 +28,13 @@ evgAcTrig::setDivider(epicsUInt32 divider) {
     if(divider > 255)
         throw std::runtime_error("EVG AC Trigger divider out of range. Range: 0 - 255"); // 0: divide by 1, 1: divide by 2, ... 255: divide by 256
 
-    epicsUInt32 temp = READ32(m_pReg, AcTrigControl)&~AcTrigControl_Divider_MASK;
-    WRITE32(m_pReg, AcTrigControl, temp|(divider<<AcTrigControl_Divider_SHIFT));
+    epicsUInt32 temp = SHADOW_READ32(m_shadow, AcTrigControl)&~AcTrigControl_Divider_MASK;
+    SHADOW_WRITE32(m_shadow, AcTrigControl, temp|(divider<<AcTrigControl_Divider_SHIFT));
 }
 
 epicsUInt32
 evgAcTrig::getDivider() const {
-    return (READ32(m_pReg, AcTrigControl)&AcTrigControl_Divider_MASK)>>AcTrigControl_Divider_SHIFT;
+    return (SHADOW_READ32(m_shadow, AcTrigControl)&AcTrigControl_Divider_MASK)>>AcTrigControl_Divider_SHIFT;
 }
 
 void
@@ -43,40 +43,40 @@ evgAcTrig::setPhase(epicsFloat64 phase) {
         throw std::runtime_error("EVG AC Trigger phase out of range. Delay range 0 ms - 25.5 ms in 0.1 ms steps");
     epicsUInt32 iphase = phase;
 
-    epicsUInt32 temp = READ32(m_pReg, AcTrigControl)&~AcTrigControl_Phase_MASK;
-    WRITE32(m_pReg, AcTrigControl, temp|(iphase<<AcTrigControl_Phase_SHIFT));
+    epicsUInt32 temp = SHADOW_READ32(m_shadow, AcTrigControl)&~AcTrigControl_Phase_MASK;
+    SHADOW_WRITE32(m_shadow, AcTrigControl, temp|(iphase<<AcTrigControl_Phase_SHIFT));
 }
 
 epicsFloat64
 evgAcTrig::getPhase() const {
-    return (READ32(m_pReg, AcTrigControl)&AcTrigControl_Phase_MASK)>>AcTrigControl_Phase_SHIFT;
+    return (SHADOW_READ32(m_shadow, AcTrigControl)&AcTrigControl_Phase_MASK)>>AcTrigControl_Phase_SHIFT;
 }
 
 void
 evgAcTrig::setBypass(bool byp) {
     if(byp)
-        BITSET32(m_pReg, AcTrigControl, AcTrigControl_Bypass);
+        SHADOW_BITSET32(m_shadow, AcTrigControl, AcTrigControl_Bypass);
     else
-        BITCLR32(m_pReg, AcTrigControl, AcTrigControl_Bypass);
+        SHADOW_BITCLR32(m_shadow, AcTrigControl, AcTrigControl_Bypass);
 }
 
 bool
 evgAcTrig::getBypass() const {
-    return !!(READ32(m_pReg, AcTrigControl)&AcTrigControl_Bypass);
+    return !!(SHADOW_READ32(m_shadow, AcTrigControl)&AcTrigControl_Bypass);
 }
 
 
 void
 evgAcTrig::setSyncSrc(bool syncSrc) {
     if(syncSrc)
-        BITSET32(m_pReg, AcTrigControl, AcTrigControl_Sync);
+        SHADOW_BITSET32(m_shadow, AcTrigControl, AcTrigControl_Sync);
     else
-        BITCLR32(m_pReg, AcTrigControl, AcTrigControl_Sync);
+        SHADOW_BITCLR32(m_shadow, AcTrigControl, AcTrigControl_Sync);
 }
 
 bool
 evgAcTrig::getSyncSrc() const {
-    return !!(READ32(m_pReg, AcTrigControl)&AcTrigControl_Sync);
+    return !!(SHADOW_READ32(m_shadow, AcTrigControl)&AcTrigControl_Sync);
 }
 
 void
@@ -87,12 +87,12 @@ evgAcTrig::setTrigEvtMap(epicsUInt16 trigEvt, bool ena) {
     epicsUInt32    mask = 1 << (trigEvt+AcTrigMap_EvtSHIFT);
 
     if(ena)
-        BITSET32(m_pReg, AcTrigMap, mask);
+        SHADOW_BITSET32(m_shadow, AcTrigMap, mask);
     else
-        BITCLR32(m_pReg, AcTrigMap, mask);
+        SHADOW_BITCLR32(m_shadow, AcTrigMap, mask);
 }
 
 epicsUInt32
 evgAcTrig::getTrigEvtMap() const {
-    return READ32(m_pReg, AcTrigMap)>>AcTrigMap_EvtSHIFT;
+    return SHADOW_READ32(m_shadow, AcTrigMap)>>AcTrigMap_EvtSHIFT;
 }
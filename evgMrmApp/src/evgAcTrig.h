@@ -3,10 +3,11 @@
 
 #include <epicsTypes.h>
 #include "mrf/object.h"
+#include "mrf/regshadow.h"
 
 class evgAcTrig : public mrf::ObjectInst<evgAcTrig> {
 public:
-    evgAcTrig(const std::string&, volatile epicsUInt8* const);
+    evgAcTrig(const std::string&, mrf::RegShadow&);
     ~evgAcTrig();
 
     /* locking done internally */
@@ -29,7 +30,7 @@ public:
     epicsUInt32 getTrigEvtMap() const;
 
 private:
-    volatile epicsUInt8* const m_pReg;
+    mrf::RegShadow& m_shadow;
 };
 
 #endif //EVG_AC_TRIG_H
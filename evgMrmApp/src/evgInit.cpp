@@ -24,6 +24,7 @@
 #include "mrf/object.h"
 #include "mrf/databuf.h"
 #include "mrf/pollirq.h"
+#include "mrf/setupqueue.h"
 #include "mrmpci.h"
 
 #include <devcsr.h>
@@ -186,6 +187,64 @@ void checkVersion(volatile epicsUInt8 *base, const MRFVersion& required,
     }
 }
 
+namespace {
+/* Construction of the evgMrm and ISR hookup.
+ * Run immediately, or later with other cards (see mrf::SetupQueue)
+ */
+struct evgVMESetup : public mrf::SetupJob
+{
+    bus_configuration bus;
+    const evgMrm::Config * const conf;
+    volatile epicsUInt8 * const regCpuAddr;
+    volatile unsigned char * const csrCpuAddr;
+
+    evgVMESetup(const char *id, const bus_configuration& bus,
+                const evgMrm::Config *conf,
+                volatile epicsUInt8 *regCpuAddr,
+                volatile unsigned char *csrCpuAddr)
+        :mrf::SetupJob(id)
+        ,bus(bus)
+        ,conf(conf)
+        ,regCpuAddr(regCpuAddr)
+        ,csrCpuAddr(csrCpuAddr)
+    {}
+    virtual ~evgVMESetup() {}
+
+    virtual void run();
+};
+
+void evgVMESetup::run()
+{
+    const epicsInt32 irqLevel = bus.vme.irqLevel, irqVector = bus.vme.irqVector;
+
+    evgMrm* evg = new evgMrm(name, conf, bus, regCpuAddr, NULL);
+
+    if(irqLevel > 0 && irqVector >= 0) {
+        /*Configure the Interrupt level and vector on the EVG board*/
+        CSRWrite8(csrCpuAddr + MRF_UCSR_DEFAULT + UCSR_IRQ_LEVEL, irqLevel&0x7);
+        CSRWrite8(csrCpuAddr + MRF_UCSR_DEFAULT + UCSR_IRQ_VECTOR, irqVector&0xff);
+
+        printf("IRQ Level: %d\nIRQ Vector: %d\n",
+               CSRRead8(csrCpuAddr + MRF_UCSR_DEFAULT + UCSR_IRQ_LEVEL),
+               CSRRead8(csrCpuAddr + MRF_UCSR_DEFAULT + UCSR_IRQ_VECTOR)
+               );
+
+
+        printf("csrCpuAddr : %p\nregCpuAddr : %p\n",csrCpuAddr, regCpuAddr);
+
+        /*Disable the interrupts and enable them at the end of iocInit via initHooks*/
+        WRITE32(regCpuAddr, IrqFlag, READ32(regCpuAddr, IrqFlag));
+        WRITE32(regCpuAddr, IrqEnable, 0);
+
+        /*Connect Interrupt handler to vector*/
+        if(devConnectInterruptVME(irqVector & 0xff, &evgMrm::isr_vme, evg)){
+            delete evg;
+            throw std::runtime_error("Failed to connect VME IRQ vector");
+        }
+    }
+}
+} // namespace
+
 extern "C"
 epicsStatus
 mrmEvgSetupVME (
@@ -276,37 +335,13 @@ mrmEvgSetupVME (
         printf("%s #Inputs FP:%u UV:%u RB:%u\n", conf->model, conf->numFrontInp,
                conf->numUnivInp, conf->numRearInp);
 
-        evgMrm* evg = new evgMrm(id, conf, bus, regCpuAddr, NULL);
-
         if(irqLevel > 0 && irqVector >= 0) {
-            /*Configure the Interrupt level and vector on the EVG board*/
-            CSRWrite8(csrCpuAddr + MRF_UCSR_DEFAULT + UCSR_IRQ_LEVEL, irqLevel&0x7);
-            CSRWrite8(csrCpuAddr + MRF_UCSR_DEFAULT + UCSR_IRQ_VECTOR, irqVector&0xff);
-
-            printf("IRQ Level: %d\nIRQ Vector: %d\n",
-                   CSRRead8(csrCpuAddr + MRF_UCSR_DEFAULT + UCSR_IRQ_LEVEL),
-                   CSRRead8(csrCpuAddr + MRF_UCSR_DEFAULT + UCSR_IRQ_VECTOR)
-                   );
-
-
-            printf("csrCpuAddr : %p\nregCpuAddr : %p\n",csrCpuAddr, regCpuAddr);
-
-            /*Disable the interrupts and enable them at the end of iocInit via initHooks*/
-            WRITE32(regCpuAddr, IrqFlag, READ32(regCpuAddr, IrqFlag));
-            WRITE32(regCpuAddr, IrqEnable, 0);
-
             // VME IRQ level will be enabled later during iocInit()
             vme_level_mask |= 1 << ((irqLevel&0x7)-1);
-
-            /*Connect Interrupt handler to vector*/
-            if(devConnectInterruptVME(irqVector & 0xff, &evgMrm::isr_vme, evg)){
-                printf("ERROR:Failed to connect VME IRQ vector %d\n"
-                             ,irqVector&0xff);
-                delete evg;
-                return -1;
-            }
         }
 
+        mrf::SetupQueue::submit(new evgVMESetup(id, bus, conf, regCpuAddr, csrCpuAddr));
+
         errlogFlush();
         return 0;
     } catch(std::exception& e) {
@@ -360,6 +395,99 @@ mrmevgs[] = {
     DEVPCI_END
 };
 
+namespace {
+struct evgPCISetup : public mrf::SetupJob
+{
+    bus_configuration bus;
+    const evgMrm::Config * const conf;
+    volatile epicsUInt8 * const BAR_plx;
+    volatile epicsUInt8 * const BAR_evg;
+    const int kifacever;
+
+    evgPCISetup(const char *id, const bus_configuration& bus,
+                const evgMrm::Config *conf,
+                volatile epicsUInt8 *BAR_plx,
+                volatile epicsUInt8 *BAR_evg,
+                int kifacever)
+        :mrf::SetupJob(id)
+        ,bus(bus)
+        ,conf(conf)
+        ,BAR_plx(BAR_plx)
+        ,BAR_evg(BAR_evg)
+        ,kifacever(kifacever)
+    {}
+    virtual ~evgPCISetup() {}
+
+    virtual void run();
+};
+
+void evgPCISetup::run()
+{
+    const epicsPCIDevice *cur = bus.pci.dev;
+
+    evgMrm* evg = new evgMrm(name, conf, bus, BAR_evg, cur);
+
+    if(mrfIRQPoll) {
+        std::string pname(name+":poll");
+        evg->irqPoller.reset(new IRQPoller(&evgMrm::isr_poll, (void*)evg,
+                                           mrfIRQPollPeriod, mrfIRQPollCPU,
+                                           pname.c_str()));
+        printf("%s: polling every %g s instead of using interrupt\n",
+               name.c_str(), evg->irqPoller->pollPeriod());
+        return;
+    }
+
+    MRFVersion ver(evg->version());
+
+#if !defined(__linux__) && !defined(_WIN32)
+    if(cur->id.device==PCI_DEVICE_ID_PLX_9030) {
+        // Enable active high interrupt1 through the PLX to the PCI bus.
+        LE_WRITE16(BAR_plx, INTCSR,	INTCSR_INT1_Enable| INTCSR_INT1_Polarity| INTCSR_PCI_Enable);
+    }
+    if(ver>=MRFVersion(0, 8, 0)) {
+        // RTOS doesn't need this, so always enable
+        WRITE32(BAR_evg, PCI_MIE, EVG_MIE_ENABLE);
+    }
+#else
+    if(ver>=MRFVersion(0, 8, 0) && kifacever>=2) {
+        // PCI master enable supported by firmware and kernel module.
+        // the kernel will set this bit when devPCIEnableInterrupt() is called
+    } else if(cur->id.device==PCI_DEVICE_ID_PLX_9030) {
+        // PLX based devices don't need special handling
+        WRITE32(BAR_evg, PCI_MIE, EVG_MIE_ENABLE);
+    } else if(ver<MRFVersion(0, 8, 0)) {
+        // old firmware and (maybe) old kernel module.
+        // this will still work, so just complain
+        printf("Warning: this configuration of FW and SW is known to have race conditions in interrupt handling.\n"
+                     "         Please consider upgrading to FW version 8.\n");
+        if(kifacever<2)
+            printf("         Also upgrade the linux kernel module to interface version 2.");
+    } else if(ver>=MRFVersion(0, 8, 0) && kifacever<2) {
+        // New firmware w/ old kernel module, this won't work
+        throw std::runtime_error("FW version 8 for this device requires a linux kernel module w/ interface version 2");
+    } else {
+        throw std::logic_error("logic error in FW/kernel module compatibility check.");
+    }
+    if(devPCIEnableInterrupt(cur)) {
+        delete evg;
+        throw std::runtime_error("Failed to enable interrupt");
+    }
+#endif
+
+    int ret;
+    /*Connect Interrupt handler to isr thread*/
+    if ((ret=devPCIConnectInterrupt(cur, &evgMrm::isr_pci, (void*) evg, 0))!=0) {
+        char buf[80];
+        errSymLookup(ret, buf, sizeof(buf));
+        printf("ERROR:Failed to connect PCI interrupt. err (%d) %s\n", ret, buf);
+        delete evg;
+        throw std::runtime_error("Failed to connect PCI interrupt");
+    } else {
+        printf("PCI interrupt connected!\n");
+    }
+}
+} // namespace
+
 extern "C"
 epicsStatus
 mrmEvgSetupPCI (
@@ -488,56 +616,7 @@ mrmEvgSetupPCI (
         printf("%s #Inputs FP:%u UV:%u RB:%u\n", conf->model, conf->numFrontInp,
                conf->numUnivInp, conf->numRearInp);
 
-        evgMrm* evg = new evgMrm(id, conf, bus, BAR_evg, cur);
-
-        MRFVersion ver(evg->version());
-
-#if !defined(__linux__) && !defined(_WIN32)
-        if(cur->id.device==PCI_DEVICE_ID_PLX_9030) {
-            // Enable active high interrupt1 through the PLX to the PCI bus.
-            LE_WRITE16(BAR_plx, INTCSR,	INTCSR_INT1_Enable| INTCSR_INT1_Polarity| INTCSR_PCI_Enable);
-        }
-        if(ver>=MRFVersion(0, 8, 0)) {
-            // RTOS doesn't need this, so always enable
-            WRITE32(BAR_evg, PCI_MIE, EVG_MIE_ENABLE);
-        }
-#else
-        if(ver>=MRFVersion(0, 8, 0) && kifacever>=2) {
-            // PCI master enable supported by firmware and kernel module.
-            // the kernel will set this bit when devPCIEnableInterrupt() is called
-        } else if(cur->id.device==PCI_DEVICE_ID_PLX_9030) {
-            // PLX based devices don't need special handling
-            WRITE32(BAR_evg, PCI_MIE, EVG_MIE_ENABLE);
-        } else if(ver<MRFVersion(0, 8, 0)) {
-            // old firmware and (maybe) old kernel module.
-            // this will still work, so just complain
-            printf("Warning: this configuration of FW and SW is known to have race conditions in interrupt handling.\n"
-                         "         Please consider upgrading to FW version 8.\n");
-            if(kifacever<2)
-                printf("         Also upgrade the linux kernel module to interface version 2.");
-        } else if(ver>=MRFVersion(0, 8, 0) && kifacever<2) {
-            // New firmware w/ old kernel module, this won't work
-            throw std::runtime_error("FW version 8 for this device requires a linux kernel module w/ interface version 2");
-        } else {
-            throw std::logic_error("logic error in FW/kernel module compatibility check.");
-        }
-        if(devPCIEnableInterrupt(cur)) {
-            printf("Failed to enable interrupt\n");
-            return -1;
-        }
-#endif
-
-        int ret;
-        /*Connect Interrupt handler to isr thread*/
-        if ((ret=devPCIConnectInterrupt(cur, &evgMrm::isr_pci, (void*) evg, 0))!=0) {
-            char buf[80];
-            errSymLookup(ret, buf, sizeof(buf));
-            printf("ERROR:Failed to connect PCI interrupt. err (%d) %s\n", ret, buf);
-            delete evg;
-            return -1;
-        } else {
-            printf("PCI interrupt connected!\n");
-        }
+        mrf::SetupQueue::submit(new evgPCISetup(id, bus, conf, BAR_plx, BAR_evg, kifacever));
 
         return 0;
 
@@ -587,11 +666,22 @@ static void mrmEvgSetupPCICallFunc(const iocshArgBuf *args) {
 
 }
 
+static const iocshArg mrmEvgSetupSimArg0 = { "Card ID", iocshArgString };
+static const iocshArg mrmEvgSetupSimArg1 = { "Period (s)", iocshArgDouble };
+static const iocshArg * const mrmEvgSetupSimArgs[2] = { &mrmEvgSetupSimArg0,
+                                                        &mrmEvgSetupSimArg1 };
+static const iocshFuncDef mrmEvgSetupSimFuncDef = { "mrmEvgSetupSim", 2,
+                                                    mrmEvgSetupSimArgs };
+static void mrmEvgSetupSimCallFunc(const iocshArgBuf *args) {
+    mrmEvgSetupSim(args[0].sval, args[1].dval);
+}
+
 extern "C"{
 static void evgMrmRegistrar() {
     initHookRegister(&inithooks);
     iocshRegister(&mrmEvgSetupVMEFuncDef, mrmEvgSetupVMECallFunc);
     iocshRegister(&mrmEvgSetupPCIFuncDef, mrmEvgSetupPCICallFunc);
+    iocshRegister(&mrmEvgSetupSimFuncDef, mrmEvgSetupSimCallFunc);
 }
 
 epicsExportRegistrar(evgMrmRegistrar);
@@ -744,7 +834,14 @@ reportCard(mrf::Object* obj, void* arg) {
         printf("\tPCI configured function: 0x%08x\n", pciDev->function);
         printf("\tPCI in slot: %s\n", pciDev->slot ? pciDev->slot : "<N/A>");
         printf("\tPCI IRQ: %u\n", pciDev->irq);
+        if(evg->irqPoller.get()) {
+            printf("\tPolled every %g s.  %u polls, mean loop %.3f us\n",
+                   evg->irqPoller->pollPeriod(), (unsigned)evg->irqPoller->pollCount(),
+                   evg->irqPoller->loopTime()*1e6);
+        }
 
+    }else if(bus->busType == busType_sim){
+        mrmEvgSimReport(evg);
     }else{
         printf("\tUnknown bus type\n");
     }
@@ -10,4 +10,8 @@
 
 #define MRF_UCSR_DEFAULT 0x7fb03
 
+// evgSim.cpp
+void mrmEvgSetupSim(const char* id, double period);
+void mrmEvgSimReport(const evgMrm *evg);
+
 #endif //EVG_INIT_H
@@ -83,13 +83,14 @@ evgMrm::evgMrm(const std::string& id,
     m_pciDevice(pciDevice),
     m_id(id),
     m_pReg(pReg),
+    m_shadow(id, pReg, EVG_REGMAP_SIZE, m_lock),
     busConfiguration(busConfig),
     m_RFref(0),
     m_fracSynFreq(0),
     m_RFDiv(1u),
     m_ClkSrc(ClkSrcInternal),
     m_seq(this, pReg),
-    m_acTrig(id+":AcTrig", pReg),
+    m_acTrig(id+":AcTrig", m_shadow),
   shadowIrqEnable(READ32(m_pReg, IrqEnable))
 {
     epicsUInt32 v, isevr;
@@ -101,6 +102,13 @@ evgMrm::evgMrm(const std::string& id,
     if(isevr!=0x2)
         throw std::runtime_error("Address does not correspond to an EVG");
 
+    // Configuration registers which only we change.
+    // Mux control includes status, so is not cached.
+    m_shadow.cache(U32_AcTrigControl);
+    m_shadow.cache(U32_AcTrigMap);
+    for(int i = 0; i < evgNumMxc; i++)
+        m_shadow.cache(U32_MuxPrescaler(i));
+
     for(int i = 0; i < evgNumEvtTrig; i++) {
         std::ostringstream name;
         name<<id<<":TrigEvt"<<i;
@@ -161,7 +169,7 @@ evgMrm::evgMrm(const std::string& id,
     if(busConfig.busType==busType_pci)
         mrf::SPIDevice::registerDev(id+":FLASH", mrf::SPIDevice(this, 1));
 
-    if(pciDevice->id.sub_device==PCI_DEVICE_ID_MRF_MTCA_EVM_300) {
+    if(pciDevice && pciDevice->id.sub_device==PCI_DEVICE_ID_MRF_MTCA_EVM_300) {
         printf("EVM automatically creating '%s:FCT', '%s:EVRD', and '%s:EVRU'\n", id.c_str(), id.c_str(), id.c_str());
         fct.reset(new FCT(this, id+":FCT", pReg+0x10000));
         evrd.reset(new EVRMRM(id+":EVRD", busConfig, &evm_evrd_conf, pReg+0x20000, 0x10000));
@@ -170,6 +178,8 @@ evgMrm::evgMrm(const std::string& id,
 }
 
 evgMrm::~evgMrm() {
+    irqPoller.reset(); // joins
+
     if(getBusConfiguration()->busType==busType_pci)
         mrf::SPIDevice::unregisterDev(name()+":FLASH");
 
@@ -191,8 +201,12 @@ evgMrm::~evgMrm() {
 
 void evgMrm::enableIRQ()
 {
+    // When polled, flags are still latched, but no interrupt is raised
+    if(irqPoller.get())
+        shadowIrqEnable &= ~EVG_IRQ_ENABLE;
+    else
+        shadowIrqEnable |= EVG_IRQ_ENABLE;
     shadowIrqEnable |= EVG_IRQ_PCIIE          | //PCIe interrupt enable,
-                       EVG_IRQ_ENABLE         |
                        EVG_IRQ_EXT_INP        |
                        EVG_IRQ_STOP_RAM(0)    |
                        EVG_IRQ_STOP_RAM(1)    |
@@ -240,6 +254,16 @@ evgMrm::getDbusStatus() const {
     return READ32(m_pReg, Status)>>16;
 }
 
+epicsUInt32
+evgMrm::irqPollCount() const {
+    return irqPoller.get() ? irqPoller->pollCount() : 0u;
+}
+
+double
+evgMrm::irqPollLoopTime() const {
+    return irqPoller.get() ? irqPoller->loopTime() : 0.0;
+}
+
 void
 evgMrm::enable(epicsUInt16 mode) {
     if(mode>2)
@@ -307,6 +331,10 @@ void
 evgMrm::isr_poll(void* arg) {
     evgMrm *evg = static_cast<evgMrm*>(arg);
 
+    // Nothing pending.  Skip the flag and enable writes of isr()
+    if(!(READ32(evg->m_pReg, IrqFlag) & evg->shadowIrqEnable))
+        return;
+
     // Call to the generic implementation
     evg->isr(evg, true);
 }
@@ -26,6 +26,8 @@
 
 #include <devLibPCI.h>
 
+#include "mrf/regshadow.h"
+
 #include "evgAcTrig.h"
 #include "evgEvtClk.h"
 #include "evgTrigEvt.h"
@@ -82,6 +84,8 @@ public:
     /** EVG    **/
     const std::string getId() const;
     volatile epicsUInt8* getRegAddr() const;
+    //! Configuration registers of subunits
+    mrf::RegShadow& getShadow() { return m_shadow; }
     MRFVersion version() const;
     std::string getFwVersionStr() const;
     std::string getSwVersion() const;
@@ -93,6 +97,11 @@ public:
     void resetMxc(bool reset);
     epicsUInt32 getDbusStatus() const;
 
+    //! Calls made by irqPoller, or 0 when using the card interrupt
+    epicsUInt32 irqPollCount() const;
+    //! Mean irqPoller loop time (sec.)
+    double irqPollLoopTime() const;
+
     IOSCANPVT timeErrorScan() const { return ioScanTimestamp; }
 
     virtual void postSoftSecondsSrc();
@@ -153,10 +162,13 @@ public:
     void show(int lvl);
 
     const epicsPCIDevice*         m_pciDevice;
+    //! Calls isr_poll() when set up with mrfIRQPoll!=0, instead of the card interrupt
+    mrf::auto_ptr<IRQPoller>      irqPoller;
 
 private:
     const std::string             m_id;
     volatile epicsUInt8* const    m_pReg;
+    mrf::RegShadow                m_shadow;
     const bus_configuration       busConfiguration;
 
     epicsFloat64               m_RFref;       // In MHz
@@ -52,12 +52,12 @@ evgMxc::setPrescaler(epicsUInt32 preScaler) {
     if(preScaler == 0 || preScaler == 1)
         throw std::runtime_error("Invalid preScaler value in Multiplexed Counter. Value should not be 0 or 1.");
 
-    WRITE32(m_pReg, MuxPrescaler(m_id), preScaler);
+    SHADOW_WRITE32(m_owner->getShadow(), MuxPrescaler(m_id), preScaler);
 }
 
 epicsUInt32
 evgMxc::getPrescaler() const {
-    return READ32(m_pReg, MuxPrescaler(m_id));
+    return SHADOW_READ32(m_owner->getShadow(), MuxPrescaler(m_id));
 }
 
 
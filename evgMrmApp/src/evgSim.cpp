@@ -0,0 +1,346 @@
+/*************************************************************************\
+* mrfioc2 is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/* A simulated EVG for testing without hardware.
+ *
+ * The register map is host memory.  Only the sequencers are emulated,
+ * through the hooks of mrf/simio.h, so this is only functional when
+ * built with MRF_SIM_IO=YES.
+ *
+ * Both sequencers run from their RAM when software triggered (cf. SeqSim),
+ * with start and end of sequence interrupts, so SoftSequence loading,
+ * double buffering, and segmented sequences can be exercised.
+ * Events sent are only counted.  A data buffer sent completes at once.
+ * Other registers are plain memory.
+ *
+ * The ISR is called from the generator thread as the interrupt would.
+ * Register accesses never call generalTime, which may take the lock
+ * of a (simulated) EVR.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <vector>
+
+#include <epicsVersion.h>
+#include <epicsThread.h>
+#include <epicsEvent.h>
+#include <epicsMutex.h>
+#include <epicsTime.h>
+
+#include <mrfCommon.h>
+#include <mrfCommonIO.h>
+#include <mrfFracSynth.h>
+#include "mrf/simio.h"
+#include "mrmSeqSim.h"
+
+#include "evgRegMap.h"
+#include "evgInit.h"
+
+#if EPICS_VERSION_INT>=VERSION_INT(3,16,1,0)
+#  define HAVE_MONOTONIC
+#endif
+
+namespace {
+
+const evgMrm::Config sim_evg = {
+    "Sim-EVG",
+    2,
+    4,
+    16,
+};
+
+// firmware 2.7.6
+const epicsUInt32 simFWVersion = (0x2u<<FPGAVersion_TYPE_SHIFT) | 0x00060207;
+
+const double simEventClock = 124.916; // MHz
+
+// Data buffer Tx control bits, as mrmShared/src/mrmDataBufTx.cpp
+const epicsUInt32 simTxDone = 0x100000;
+const epicsUInt32 simTxRun  = 0x080000;
+const epicsUInt32 simTxTrig = 0x040000;
+
+// Bounds the work done in one wakeup if the generator falls behind
+const size_t simMaxBatch = 4096;
+
+struct EVGSim : public epicsThreadRunable
+{
+    epicsUInt32 * const regs;
+
+    mutable epicsMutex lock;
+    epicsEvent wakeup;
+    bool stop;
+
+    // guarded by lock
+    epicsUInt32 irqflags;
+    epicsUInt64 count_events, count_behind, count_seq;
+    // seconds since start
+    SeqSim seq0, seq1;
+#ifdef HAVE_MONOTONIC
+    epicsUInt64 startMono;
+#else
+    double lastElapsed;
+#endif
+
+    epicsTimeStamp start;
+    const double tickPeriod;
+
+    evgMrm *evg;
+
+    epicsThread runner;
+
+    static epicsUInt32* allocRegs()
+    {
+        epicsUInt32 *regs = (epicsUInt32*)calloc(EVG_REGMAP_SIZE/4, 4);
+        if(!regs)
+            throw std::bad_alloc();
+        return regs;
+    }
+
+    explicit EVGSim(double tickPeriod)
+        :regs(allocRegs())
+        ,stop(false)
+        ,irqflags(0)
+        ,count_events(0), count_behind(0), count_seq(0)
+        ,seq0(&reg(U32_SeqControl(0)), &reg(U32_SeqRamTS(0, 0)), 31)
+        ,seq1(&reg(U32_SeqControl(1)), &reg(U32_SeqRamTS(1, 0)), 31)
+#ifdef HAVE_MONOTONIC
+        ,startMono(epicsMonotonicGet())
+#else
+        ,lastElapsed(0.0)
+#endif
+        ,tickPeriod(tickPeriod)
+        ,evg(0)
+        ,runner(*this, "EVGSim",
+                epicsThreadGetStackSize(epicsThreadStackSmall),
+                epicsThreadPriorityHigh)
+    {
+        double err;
+        reg(U32_FPGAVersion) = simFWVersion;
+        reg(U32_FracSynthWord) = FracSynthControlWord(simEventClock, MRF_FRAC_SYNTH_REF, 0, &err);
+        reg(U32_uSecDiv) = epicsUInt32(simEventClock);
+        reg(U32_ClockControl) = ClockControl_plllock|ClockControl_cglock;
+
+        epicsTimeGetCurrent(&start);
+
+        mrfSimIORegister(regs, EVG_REGMAP_SIZE, &access, this);
+    }
+    virtual ~EVGSim() {}
+
+    epicsUInt32& reg(epicsUInt32 off) { return regs[off/4]; }
+
+    SeqSim& seq(unsigned i) { return i ? seq1 : seq0; }
+
+    // Seconds since start.  caller must hold lock.
+    // As of the last generator wakeup if epicsMonotonicGet() is not available.
+    double elapsed()
+    {
+#ifdef HAVE_MONOTONIC
+        return (epicsMonotonicGet()-startMono)*1e-9;
+#else
+        return lastElapsed;
+#endif
+    }
+
+    // caller must hold lock
+    double evtClkHz()
+    {
+        return FracSynthAnalyze(reg(U32_FracSynthWord), MRF_FRAC_SYNTH_REF, 0)*1e6;
+    }
+
+    // caller must hold lock
+    bool irqPending()
+    {
+        epicsUInt32 ena = reg(U32_IrqEnable);
+        return (ena&EVG_IRQ_ENABLE) && (irqflags&ena&0xffff);
+    }
+
+    // caller must hold lock.  flags from SeqSim
+    void seqFlags(unsigned i, unsigned flags)
+    {
+        if(flags&SeqSim::Ended)
+            irqflags |= EVG_IRQ_STOP_RAM(i);
+        if(flags&SeqSim::Started) {
+            count_seq++;
+            irqflags |= EVG_IRQ_START_RAM(i);
+        }
+    }
+
+    void generate()
+    {
+#ifndef HAVE_MONOTONIC
+        // Not with our lock held
+        epicsTimeStamp T;
+        epicsTimeGetCurrent(&T);
+#endif
+
+        SCOPED_LOCK(lock);
+#ifndef HAVE_MONOTONIC
+        lastElapsed = epicsTimeDiffInSeconds(&T, &start);
+#endif
+        const double now = elapsed(), clk = evtClkHz();
+
+        for(unsigned i=0; i<2; i++) {
+            double at;
+            for(size_t n=0; seq(i).next(clk, at) && at<=now; n++) {
+                if(n==simMaxBatch) {
+                    // resume on the next wakeup
+                    count_behind++;
+                    break;
+                }
+                epicsUInt8 code;
+                seqFlags(i, seq(i).step(clk, at, &code));
+                if(code)
+                    count_events++;
+            }
+        }
+    }
+
+    virtual void run()
+    {
+        while(true) {
+            wakeup.wait(tickPeriod);
+            {
+                SCOPED_LOCK(lock);
+                if(stop)
+                    break;
+            }
+
+            generate();
+
+            bool raise;
+            {
+                SCOPED_LOCK(lock);
+                raise = irqPending();
+            }
+            // as if from the interrupt.  Not while holding our lock.
+            if(raise)
+                evgMrm::isr_poll(evg);
+        }
+    }
+
+    void access32(epicsUInt32 offset, bool write, epicsUInt32 *val, bool& handled)
+    {
+        handled = true;
+        SCOPED_LOCK(lock);
+
+        if(!write) {
+            switch(offset) {
+            case U32_IrqFlag:
+                *val = irqflags;
+                return;
+            case U32_SeqControl(0):
+            case U32_SeqControl(1):
+                *val = seq(offset==U32_SeqControl(1)).readCtrl();
+                return;
+            }
+
+        } else {
+            switch(offset) {
+            case U32_IrqFlag:
+                // write 1 to clear
+                irqflags &= ~*val;
+                return;
+            case U32_IrqEnable:
+                reg(offset) = *val;
+                // re-enabled with flags still set
+                if(irqPending())
+                    wakeup.signal();
+                return;
+            case U32_SeqControl(0):
+            case U32_SeqControl(1): {
+                const unsigned i = offset==U32_SeqControl(1);
+                const unsigned flags = seq(i).writeCtrl(*val, elapsed());
+                seqFlags(i, flags);
+                if(flags)
+                    wakeup.signal();
+                return;
+            }
+            case U32_DataBufferControl:
+                if(*val&simTxTrig)
+                    reg(offset) = (*val&~(simTxTrig|simTxRun))|simTxDone;
+                else
+                    reg(offset) = *val;
+                return;
+            }
+        }
+        handled = false;
+    }
+
+    static int access(void *pvt, epicsUInt32 offset, unsigned width,
+                      int write, epicsUInt32 *val)
+    {
+        EVGSim *self = static_cast<EVGSim*>(pvt);
+        bool handled = false;
+        if(width==32)
+            self->access32(offset, write, val, handled);
+        return handled;
+    }
+
+    void report() const
+    {
+        SCOPED_LOCK(lock);
+        printf("\tSimulated.  %llu sequences, %llu events sent, behind %llu times\n",
+               (unsigned long long)count_seq,
+               (unsigned long long)count_events,
+               (unsigned long long)count_behind);
+    }
+};
+
+// only added to before iocInit()
+std::vector<EVGSim*> sims;
+
+} // namespace
+
+/** @brief Setup a simulated EVG
+ *
+ * Requires a build with MRF_SIM_IO=YES.
+ * Sequences loaded through the EVG's SeqManager run when software triggered.
+ *
+ @code
+   > mrmEvgSetupSim("EVG1", 0.001)
+ @endcode
+ *
+ @param id EVG identifier
+ @param period Generator wakeup interval in seconds.  0 for 1 ms.
+ */
+void
+mrmEvgSetupSim(const char* id, double period)
+{
+try {
+#ifndef MRF_SIM_IO
+    throw std::runtime_error("Simulation requires a build with MRF_SIM_IO=YES");
+#endif
+    if(mrf::Object::getObject(id))
+        throw std::runtime_error("Object ID already in use");
+
+    if(period<=0.0)
+        period = 0.001;
+
+    // Never freed, the simulated register map must outlive the evgMrm
+    EVGSim *sim = new EVGSim(period);
+
+    bus_configuration bus;
+    bus.busType = busType_sim;
+
+    sim->evg = new evgMrm(id, &sim_evg, bus,
+                          (volatile epicsUInt8*)sim->regs, NULL);
+    sims.push_back(sim);
+
+    sim->runner.start();
+} catch(std::exception& e) {
+    printf("Error: %s\n",e.what());
+}
+}
+
+void
+mrmEvgSimReport(const evgMrm *evg)
+{
+    for(size_t i=0; i<sims.size(); i++) {
+        if(sims[i]->evg==evg)
+            sims[i]->report();
+    }
+}
@@ -22,6 +22,8 @@
 #include <menuFtype.h>
 #include <aSubRecord.h>
 
+#include "seqmerge.h"
+
 
 #define NINPUTS (aSubRecordU - aSubRecordA)
 
@@ -169,6 +171,7 @@ fail:
 }
 
 /**@brief Merge several sorted sequences.
+ * Elements with code 0 are skipped.  cf. seqMerge()
  *
  *  Inputs
  *@param A First time waveform
@@ -190,8 +193,10 @@ fail:
 long seq_merge(aSubRecord *prec)
 {
     unsigned int i;
-    epicsUInt32 in_pos[NINPUTS/2]; // position in each pair of input times/codes
+    seqInput inputs[NINPUTS/2];
     unsigned int ninputs;
+    seqMergeResult res;
+    seqMergeStatus sts;
 
     epicsUInt32 maxout = prec->nova;
     double *out_T = prec->vala;
@@ -200,8 +205,6 @@ long seq_merge(aSubRecord *prec)
     if(prec->nsev>=INVALID_ALARM) /* Invalid inputs */
         return -1;
 
-    memset(in_pos, 0, sizeof(in_pos));
-
     if(maxout > prec->novb)
         maxout = prec->novb;
 
@@ -229,6 +232,11 @@ long seq_merge(aSubRecord *prec)
                             (char)('A'+2*N+1), (&prec->nea)[2*N+1]);
                 goto fail;
             }
+
+            seqInputInit(&inputs[N],
+                         (const double*)(&prec->a)[2*N],
+                         (const epicsUInt8*)(&prec->a)[2*N+1],
+                         (&prec->nea)[2*N]);
         }
 
         ninputs = N;
@@ -239,87 +247,41 @@ long seq_merge(aSubRecord *prec)
         goto fail;
     }
 
-    if(seqConstDebug>1) {
-        printf("%s Merge\n", prec->name);
+    sts = seqMerge(inputs, ninputs, out_T, out_C, maxout, &res);
+    i = res.nout;
+
+    switch(sts) {
+    case seqMergeOK:
+        break;
+    case seqMergeDuplicate:
+        epicsPrintf("%s: Dup timestamp.  %c[%u] and %c[%u]\n",
+                    prec->name,
+                    'A'+(2*res.input), res.pos,
+                    'A'+(2*res.other), res.otherpos);
+        goto fail;
+    case seqMergeUnsorted:
+        epicsPrintf("%s: input %c times not sorted!\n", prec->name, 'A'+(2*res.input));
+        goto fail;
+    case seqMergeOverflow:
+        epicsPrintf("%s.%c: Not completely consumed!  %u of %u\n",
+                    prec->name, 'A'+(2*res.input), res.pos, (&prec->nea)[2*res.input]);
+        goto fail;
+    default:
+        epicsPrintf("%s: merge fails: %s\n", prec->name, seqMergeStatusStr(sts));
+        goto fail;
     }
 
-    for(i=0; i<maxout; i++) {
-        unsigned int N;
-        int found_element = -1;
-        double last_time = -1.0; /* Initial value not used, but silences warning */
-
-        for(N=0; N<ninputs; N++) {
-            double *T;
-            epicsUInt8 *C;
-	    
-            T = (double*)(&prec->a)[2*N];
-            C = (epicsUInt8*)(&prec->a)[2*N+1];
-
-            while(in_pos[N]<(&prec->nea)[2*N] && C[in_pos[N]]==0)
-                in_pos[N]++; /* skip entries with code 0 */
-
-            if(in_pos[N]==(&prec->nea)[2*N])
-                continue; /* This input completely consumed */
-
-            if(found_element==-1 || T[in_pos[N]]<last_time) {
-                found_element = N;
-                out_T[i] = T[in_pos[N]];
-                out_C[i] = C[in_pos[N]];
-                last_time = out_T[i];
-
-            } else if(T[in_pos[N]]==last_time && found_element!=-1) {
-                /* Duplicate timestamp! */
-                printf("%s: Dup timestamp.  %c[%u] and %c[%u]\n",
-                       prec->name,
-                       'A'+(2*found_element), in_pos[found_element]-1,
-                       'A'+(2*N), in_pos[N]);
-                printf(" Found element: %d\n", found_element);
-                printf(" i=%u, N=%u, ninputs=%u\n", i, N, ninputs);
-                printf(" Out %u C=%u T=%f  [", i, out_C[i], out_T[i]);
-                for(N=0; N<ninputs; N++)
-                    printf("%u, ", in_pos[N/2]);
-                printf("]\n");
-                goto fail;
-            }
-        }
-
-        if(found_element==-1) {
-            /* All inputs consumed */
-            goto done;
-        } else if(i>0 && out_T[i] < out_T[i-1]) {
-            epicsPrintf("%s: input %c times not sorted!\n", prec->name, 'A'+(2*found_element));
-	    goto fail;
-        } else {
-            in_pos[found_element]++;
-        }
-
-        if(seqConstDebug>1) {
-            printf("Out %u C=%u T=%f  [", i, out_C[i], out_T[i]);
-            for(N=0; N<ninputs; N++)
-                printf("%u, ", in_pos[N/2]);
-            printf("\n");
-        }
+    if(seqConstDebug>1) {
+        unsigned int n;
+        printf("%s Merge\n", prec->name);
+        for(n=0; n<i; n++)
+            printf("Out %u C=%u T=%f\n", n, out_C[n], out_T[n]);
     }
 
     if(seqConstDebug>0) {
         epicsPrintf("%s: merge result has %u element\n", prec->name, i);
     }
 
-    {
-        unsigned int N;
-        unsigned int nogood = 0;
-        for(N=0; N<ninputs; N++) {
-            if(in_pos[N]!=(&prec->nea)[2*N]) {
-                epicsPrintf("%s.%c: Not completely consumed!  %u of %u\n",
-			    prec->name, 'A'+(2*N), in_pos[N], (&prec->nea)[2*N]);
-		nogood = 1;
-            }
-        }
-        if(nogood)
-          goto fail;
-    }
-
-done:
     if(i==0) {
         if(seqConstDebug>0)
             epicsPrintf("%s: merged yields empty sequence\n", prec->name);
@@ -364,7 +326,6 @@ long seq_shift(aSubRecord *prec)
     double delay;
     const double *input=(const double*)prec->b;
     double *output=(double*)prec->vala;
-    epicsUInt32 i;
 
     if(prec->fta!=menuFtypeDOUBLE
        || prec->ftb!=menuFtypeDOUBLE
@@ -379,8 +340,7 @@ long seq_shift(aSubRecord *prec)
 
     delay = *(double*)prec->a;
 
-    for(i=0; i<prec->neb; i++)
-        output[i] = input[i]+delay;
+    seqShift(input, output, prec->neb, delay);
 
     prec->neva = prec->neb;
 
@@ -409,18 +369,15 @@ long seq_mask(aSubRecord *prec)
     const epicsUInt8 *inp = (const epicsUInt8*)prec->a;
     const epicsUInt32 *mask = (const epicsUInt32*)prec->b;
     epicsUInt8 *out = (epicsUInt8*)prec->vala;
-    epicsUInt32 i, num = prec->neb*32;
+    epicsUInt32 num = prec->neb*32;
 
     if(num>prec->nea)
         num = prec->nea;
     if(num>prec->nova)
         num = prec->nova;
 
-    for(i=0; i<num; i++) {
-        epicsUInt8 M = (mask[i/32]>>(i%32))&0x1;
-        out[i] = M ? inp[i] : 0;
-    }
-    
+    seqMask(inp, out, num, mask);
+
     prec->neva = num;
 
     return 0;
@@ -0,0 +1,182 @@
+/*************************************************************************\
+* mrfioc2 is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+#include <stdlib.h>
+
+#include <dbDefs.h>
+
+#define epicsExportSharedSymbols
+#include "seqmerge.h"
+
+/* current head of one input */
+typedef struct {
+    double T;
+    unsigned input;
+    epicsUInt32 pos;
+} cursor;
+
+/* Inputs at the same time are ordered by index, which keeps the
+ * result independent of heap layout.
+ */
+static int cursorLess(const cursor *a, const cursor *b)
+{
+    return a->T < b->T || (a->T == b->T && a->input < b->input);
+}
+
+static void siftDown(cursor *heap, unsigned nheap, unsigned i)
+{
+    while(1) {
+        unsigned l = 2*i+1, r = l+1, m = i;
+        cursor tmp;
+
+        if(l<nheap && cursorLess(&heap[l], &heap[m]))
+            m = l;
+        if(r<nheap && cursorLess(&heap[r], &heap[m]))
+            m = r;
+        if(m==i)
+            return;
+        tmp = heap[i];
+        heap[i] = heap[m];
+        heap[m] = tmp;
+        i = m;
+    }
+}
+
+/* Move to the first element at or after pos which is not skipped.
+ * returns 0 when the input is consumed.
+ */
+static int seek(const seqInput *inp, cursor *cur, epicsUInt32 pos)
+{
+    for(; pos<inp->len; pos++) {
+        if(inp->C[pos]==0)
+            continue;
+        if(inp->mask) {
+            if(pos/32u >= inp->masklen)
+                return 0;
+            if(!((inp->mask[pos/32u]>>(pos%32u))&1u))
+                continue;
+        }
+        cur->pos = pos;
+        cur->T = inp->T[pos] + inp->shift;
+        return 1;
+    }
+    return 0;
+}
+
+void seqInputInit(seqInput *inp, const double *T, const epicsUInt8 *C, epicsUInt32 len)
+{
+    inp->T = T;
+    inp->C = C;
+    inp->len = len;
+    inp->shift = 0.0;
+    inp->mask = NULL;
+    inp->masklen = 0;
+}
+
+seqMergeStatus seqMerge(const seqInput *inp, unsigned ninp,
+                        double *outT, epicsUInt8 *outC,
+                        epicsUInt32 maxout, seqMergeResult *res)
+{
+    cursor heapbuf[32]; /* enough for the aSub record */
+    cursor *heap = heapbuf;
+    unsigned nheap = 0, i;
+    epicsUInt32 nout = 0;
+    seqMergeStatus ret = seqMergeOK;
+
+    res->nout = 0;
+    res->input = res->other = 0;
+    res->pos = res->otherpos = 0;
+
+    if(ninp > NELEMENTS(heapbuf)) {
+        heap = malloc(ninp*sizeof(*heap));
+        if(!heap)
+            return seqMergeNoMemory;
+    }
+
+    for(i=0; i<ninp; i++) {
+        heap[nheap].input = i;
+        if(seek(&inp[i], &heap[nheap], 0))
+            nheap++;
+    }
+    for(i=nheap/2; i>0; i--)
+        siftDown(heap, nheap, i-1);
+
+    while(nheap) {
+        cursor *top = &heap[0];
+        const seqInput *I = &inp[top->input];
+        double prev = top->T;
+        unsigned c;
+
+        if(nout==maxout) {
+            ret = seqMergeOverflow;
+            res->input = top->input;
+            res->pos = top->pos;
+            break;
+        }
+
+        /* The next smallest head is a child of the root */
+        for(c=1; c<=2 && c<nheap; c++) {
+            if(heap[c].T == prev) {
+                ret = seqMergeDuplicate;
+                res->input = top->input;
+                res->pos = top->pos;
+                res->other = heap[c].input;
+                res->otherpos = heap[c].pos;
+                goto done;
+            }
+        }
+
+        outT[nout] = prev;
+        outC[nout] = I->C[top->pos];
+        nout++;
+
+        if(seek(I, top, top->pos+1)) {
+            if(top->T < prev) {
+                ret = seqMergeUnsorted;
+                res->input = top->input;
+                res->pos = top->pos;
+                break;
+            }
+        } else {
+            heap[0] = heap[--nheap];
+        }
+        siftDown(heap, nheap, 0);
+    }
+
+done:
+    res->nout = nout;
+    if(heap!=heapbuf)
+        free(heap);
+    return ret;
+}
+
+const char *seqMergeStatusStr(seqMergeStatus sts)
+{
+    switch(sts) {
+    case seqMergeOK: return "OK";
+    case seqMergeDuplicate: return "Duplicate time";
+    case seqMergeUnsorted: return "Input not sorted";
+    case seqMergeOverflow: return "Output too short";
+    case seqMergeNoMemory: return "No memory";
+    }
+    return "Unknown";
+}
+
+void seqShift(const double *in, double *out, epicsUInt32 len, double delay)
+{
+    epicsUInt32 i;
+    for(i=0; i<len; i++)
+        out[i] = in[i]+delay;
+}
+
+void seqMask(const epicsUInt8 *in, epicsUInt8 *out, epicsUInt32 len,
+             const epicsUInt32 *mask)
+{
+    epicsUInt32 i;
+    for(i=0; i<len; i++) {
+        epicsUInt8 M = (mask[i/32]>>(i%32))&0x1;
+        out[i] = M ? in[i] : 0;
+    }
+}
@@ -0,0 +1,78 @@
+/*************************************************************************\
+* mrfioc2 is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+#ifndef SEQMERGE_H
+#define SEQMERGE_H
+
+#include <epicsTypes.h>
+#include <shareLib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief One sorted input sequence for seqMerge()
+ *
+ * The shift and mask stages are applied as each element is consumed,
+ * so no intermediate copies are made.
+ * Initialize with seqInputInit(), then set the optional stages.
+ */
+typedef struct {
+    const double *T;        /* times.  Non-decreasing */
+    const epicsUInt8 *C;    /* codes.  Elements with code 0 are skipped */
+    epicsUInt32 len;
+    double shift;           /* added to each time */
+    /* If not NULL, element i is kept only if bit i%32 of mask[i/32] is set.
+     * Elements beyond 32*masklen are dropped.
+     */
+    const epicsUInt32 *mask;
+    epicsUInt32 masklen;
+} seqInput;
+
+typedef enum {
+    seqMergeOK = 0,
+    seqMergeDuplicate,  /* two inputs have an element at the same time */
+    seqMergeUnsorted,   /* an input is not sorted */
+    seqMergeOverflow,   /* output too short */
+    seqMergeNoMemory
+} seqMergeStatus;
+
+typedef struct {
+    epicsUInt32 nout;   /* # of elements written to output */
+    /* On error, the input index and element position which failed. */
+    unsigned input;
+    epicsUInt32 pos;
+    /* For seqMergeDuplicate, the other input and position */
+    unsigned other;
+    epicsUInt32 otherpos;
+} seqMergeResult;
+
+epicsShareFunc void seqInputInit(seqInput *inp, const double *T,
+                                 const epicsUInt8 *C, epicsUInt32 len);
+
+/** @brief k-way merge of sorted sequences, with a binary heap of input heads.
+ *
+ * O(N log K) for N elements from K inputs.
+ * Elements at the same time from different inputs are an error.
+ * Elements at the same time within one input are kept, in order.
+ *
+ * @returns seqMergeOK, or the reason for failure.  res is always filled.
+ */
+epicsShareFunc seqMergeStatus seqMerge(const seqInput *inp, unsigned ninp,
+                                       double *outT, epicsUInt8 *outC,
+                                       epicsUInt32 maxout, seqMergeResult *res);
+
+epicsShareFunc const char *seqMergeStatusStr(seqMergeStatus sts);
+
+/* Single stages.  in and out may be the same array. */
+epicsShareFunc void seqShift(const double *in, double *out, epicsUInt32 len,
+                             double delay);
+epicsShareFunc void seqMask(const epicsUInt8 *in, epicsUInt8 *out, epicsUInt32 len,
+                            const epicsUInt32 *mask);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SEQMERGE_H */
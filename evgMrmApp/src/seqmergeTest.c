@@ -0,0 +1,208 @@
+/*************************************************************************\
+* mrfioc2 is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+#include <string.h>
+
+#include "epicsUnitTest.h"
+#include "testMain.h"
+
+#include "seqmerge.h"
+
+#define NOUT 64
+
+static double outT[NOUT];
+static epicsUInt8 outC[NOUT];
+
+static int checkOut(const double *T, const epicsUInt8 *C, epicsUInt32 n)
+{
+    epicsUInt32 i;
+    for(i=0; i<n; i++) {
+        if(outT[i]!=T[i] || outC[i]!=C[i]) {
+            testDiag("[%u] %g,%u != %g,%u", (unsigned)i,
+                     outT[i], outC[i], T[i], C[i]);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void testMergeTwo(void)
+{
+    static const double T0[] = {1.0, 3.0, 5.0}, T1[] = {2.0, 4.0};
+    static const epicsUInt8 C0[] = {10, 30, 50}, C1[] = {20, 40};
+    static const double eT[] = {1.0, 2.0, 3.0, 4.0, 5.0};
+    static const epicsUInt8 eC[] = {10, 20, 30, 40, 50};
+    seqInput inp[2];
+    seqMergeResult res;
+
+    testDiag("testMergeTwo()");
+
+    seqInputInit(&inp[0], T0, C0, 3);
+    seqInputInit(&inp[1], T1, C1, 2);
+
+    testOk1(seqMerge(inp, 2, outT, outC, NOUT, &res)==seqMergeOK);
+    testOk1(res.nout==5);
+    testOk1(checkOut(eT, eC, 5));
+}
+
+/* Equal times within one input are kept, in order */
+static void testSameInputTie(void)
+{
+    static const double T0[] = {1.0, 1.0, 2.0}, T1[] = {3.0};
+    static const epicsUInt8 C0[] = {1, 2, 3}, C1[] = {4};
+    static const double eT[] = {1.0, 1.0, 2.0, 3.0};
+    static const epicsUInt8 eC[] = {1, 2, 3, 4};
+    seqInput inp[2];
+    seqMergeResult res;
+
+    testDiag("testSameInputTie()");
+
+    seqInputInit(&inp[0], T0, C0, 3);
+    seqInputInit(&inp[1], T1, C1, 1);
+
+    testOk1(seqMerge(inp, 2, outT, outC, NOUT, &res)==seqMergeOK);
+    testOk1(res.nout==4);
+    testOk1(checkOut(eT, eC, 4));
+}
+
+/* Equal times in different inputs are an error */
+static void testCrossInputTie(void)
+{
+    static const double T0[] = {1.0, 5.0}, T1[] = {2.0, 6.0}, T2[] = {3.0, 5.0};
+    static const epicsUInt8 C[] = {1, 2};
+    double Tn[8];
+    seqInput inp[8];
+    seqMergeResult res;
+    unsigned i;
+
+    testDiag("testCrossInputTie()");
+
+    seqInputInit(&inp[0], T0, C, 2);
+    seqInputInit(&inp[1], T1, C, 2);
+    seqInputInit(&inp[2], T2, C, 2);
+
+    testOk1(seqMerge(inp, 3, outT, outC, NOUT, &res)==seqMergeDuplicate);
+    testOk1(res.nout==3);
+    testOk(res.input==0 && res.pos==1 && res.other==2 && res.otherpos==1,
+           "input %u pos %u other %u otherpos %u",
+           res.input, (unsigned)res.pos, res.other, (unsigned)res.otherpos);
+
+    /* The duplicate is not a child of the root until the heads before it
+     * are consumed.  Inputs 3 and 7 start at the same time.
+     */
+    for(i=0; i<8; i++) {
+        Tn[i] = 10.0+(i==7 ? 3 : i);
+        seqInputInit(&inp[i], &Tn[i], C, 1);
+    }
+
+    testOk1(seqMerge(inp, 8, outT, outC, NOUT, &res)==seqMergeDuplicate);
+    testOk1(res.nout==3);
+    testOk(res.input==3 && res.other==7, "input %u other %u", res.input, res.other);
+}
+
+static void testUnsorted(void)
+{
+    static const double T0[] = {1.0, 3.0, 2.0};
+    static const epicsUInt8 C0[] = {1, 2, 3};
+    seqInput inp;
+    seqMergeResult res;
+
+    testDiag("testUnsorted()");
+
+    seqInputInit(&inp, T0, C0, 3);
+
+    testOk1(seqMerge(&inp, 1, outT, outC, NOUT, &res)==seqMergeUnsorted);
+    testOk(res.input==0 && res.pos==2, "input %u pos %u", res.input, (unsigned)res.pos);
+}
+
+static void testOverflow(void)
+{
+    static const double T0[] = {1.0, 2.0, 3.0, 4.0};
+    static const epicsUInt8 C0[] = {1, 2, 3, 4}, Cz[] = {1, 2, 0, 0};
+    seqInput inp;
+    seqMergeResult res;
+
+    testDiag("testOverflow()");
+
+    seqInputInit(&inp, T0, C0, 4);
+
+    testOk1(seqMerge(&inp, 1, outT, outC, 2, &res)==seqMergeOverflow);
+    testOk1(res.nout==2);
+    testOk(res.input==0 && res.pos==2, "input %u pos %u", res.input, (unsigned)res.pos);
+
+    /* skipped code 0 entries after the last kept one don't overflow */
+    seqInputInit(&inp, T0, Cz, 4);
+
+    testOk1(seqMerge(&inp, 1, outT, outC, 2, &res)==seqMergeOK);
+    testOk1(res.nout==2);
+}
+
+static void testMaskShift(void)
+{
+    double T0[40];
+    epicsUInt8 C0[40];
+    epicsUInt32 mask[1] = {0xfffffffd}; /* drop element 1 */
+    seqInput inp;
+    seqMergeResult res;
+    unsigned i;
+
+    testDiag("testMaskShift()");
+
+    for(i=0; i<40; i++) {
+        T0[i] = i;
+        C0[i] = i+1;
+    }
+
+    seqInputInit(&inp, T0, C0, 40);
+    inp.mask = mask;
+    inp.masklen = 1;
+    inp.shift = 0.5;
+
+    testOk1(seqMerge(&inp, 1, outT, outC, NOUT, &res)==seqMergeOK);
+    /* elements beyond 32*masklen are dropped */
+    testOk(res.nout==31, "nout %u", (unsigned)res.nout);
+    testOk1(outT[0]==0.5 && outC[0]==1);
+    testOk1(outT[1]==2.5 && outC[1]==3);
+    testOk1(outT[30]==31.5 && outC[30]==32);
+}
+
+/* More inputs than the on-stack heap */
+static void testManyInputs(void)
+{
+    enum {N=40};
+    double T[N];
+    epicsUInt8 C[N];
+    seqInput inp[N];
+    seqMergeResult res;
+    unsigned i;
+    int ok = 1;
+
+    testDiag("testManyInputs()");
+
+    for(i=0; i<N; i++) {
+        T[i] = N-1-i;
+        C[i] = i+1;
+        seqInputInit(&inp[i], &T[i], &C[i], 1);
+    }
+
+    testOk1(seqMerge(inp, N, outT, outC, NOUT, &res)==seqMergeOK);
+    testOk1(res.nout==N);
+    for(i=0; i<N; i++)
+        ok &= outT[i]==i && outC[i]==N-i;
+    testOk1(ok);
+}
+
+MAIN(seqmergeTest)
+{
+    testPlan(27);
+    testMergeTwo();
+    testSameInputTie();
+    testCrossInputTie();
+    testUnsorted();
+    testOverflow();
+    testMaskShift();
+    testManyInputs();
+    return testDone();
+}
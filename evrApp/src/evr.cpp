@@ -62,6 +62,8 @@ std::string EVR::position() const
             position << " slot=" << busConfiguration.pci.dev->slot;
     } else if(busConfiguration.busType == busType_vme) {
         position << "Slot #" << busConfiguration.vme.slot;
+    } else if(busConfiguration.busType == busType_sim) {
+        position << "Simulated";
     } else {
         position << "Unknown position";
     }
@@ -13,7 +13,9 @@
 
 #include <cstdlib>
 #include <cstdio>
+#include <cstring>
 #include <stdexcept>
+#include <algorithm>
 
 #include <errlog.h>
 #include <epicsTypes.h>
@@ -60,14 +62,25 @@ void defaulterr(void *, epicsStatus err,
     }
 }
 
-bufRxManager::bufRxManager(const std::string& n, unsigned int qdepth, unsigned int bsize)
+bufRxManager::bufRxManager(const std::string& n, unsigned int qdepth, unsigned int bsize,
+                           unsigned int maxdepth)
   :dataBufRx(n)
   ,guard()
   ,onerror(defaulterr)
   ,onerror_arg(NULL)
-  ,m_bsize(bsize ? bsize : 2048)
+  ,m_bsize(bsize ? (bsize+3u)&~3u : 2048) // drainbuf() copies whole words
+  ,m_maxdepth(std::max(qdepth, maxdepth))
+  ,nbufs(qdepth)
+  ,ninuse(0)
+  ,inuseHWM(0)
+  ,pooldrop(0)
+  ,residency(0.0)
 {
     ellInit(&dispatch);
+    for(unsigned int i=0; i<NELEMENTS(byproto); i++)
+        ellInit(&byproto[i]);
+    memset(protoCount, 0, sizeof(protoCount));
+    memset(protoDrop, 0, sizeof(protoDrop));
     ellInit(&freebufs);
     ellInit(&usedbufs);
 
@@ -79,6 +92,12 @@ bufRxManager::bufRxManager(const std::string& n, unsigned int qdepth, unsigned i
     }
 }
 
+bufRxManager::buffer*
+bufRxManager::allocBuffer() const
+{
+    return (buffer*)calloc(1, sizeof(buffer)-1+m_bsize);
+}
+
 bufRxManager::~bufRxManager()
 {
     ELLNODE *node, *next;
@@ -97,31 +116,50 @@ bufRxManager::~bufRxManager()
 epicsUInt8*
 bufRxManager::getFree(unsigned int* blen)
 {
-    ELLNODE *node;
+    buffer *buf=NULL;
+    bool grow=false;
     {
         SCOPED_LOCK(guard);
-        node=ellGet(&freebufs);
+        ELLNODE *node=ellGet(&freebufs);
+        if (node) {
+            buf=CONTAINER(node, buffer, node);
+        } else if (nbufs<m_maxdepth) {
+            nbufs++; // reserve
+            grow=true;
+        } else {
+            pooldrop++;
+            return NULL;
+        }
     }
 
-    if (!node)
-        return NULL;
+    if (grow) {
+        // allocate outside of the lock
+        buf=allocBuffer();
+        if (!buf) {
+            SCOPED_LOCK(guard);
+            nbufs--;
+            pooldrop++;
+            return NULL;
+        }
+    }
 
-    buffer *buf=CONTAINER(node, buffer, node);
+    {
+        SCOPED_LOCK(guard);
+        if (++ninuse>inuseHWM)
+            inuseHWM=ninuse;
+    }
 
     if (blen) *blen=bsize();
 
     buf->used=0;
+    buf->refs=0;
     return buf->data;
 }
 
 void
 bufRxManager::receive(epicsUInt8* raw,unsigned int usedlen)
 {
-    /* CONTAINER doesn't work when the member is a pointer
-     * because the GNU version's check isn't correct
-    buffer *buf=CONTAINER(raw, buffer, data);
-     */
-    buffer *buf=(buffer*)((char*)(raw) - offsetof(buffer, data));
+    buffer *buf=fromData(raw);
 
     if (usedlen>bsize())
         throw std::out_of_range("User admitted overflowing Rx buffer");
@@ -131,7 +169,8 @@ bufRxManager::receive(epicsUInt8* raw,unsigned int usedlen)
         // buffer returned w/o being used
         {
             SCOPED_LOCK(guard);
-            ellAdd(&freebufs, &buf->node);
+            buf->rxtime.secPastEpoch=0;
+            release(buf);
         }
         if(evrMrmSeqRxDebug>=2) {
             errlogPrintf("buffer ignored\n");
@@ -139,6 +178,8 @@ bufRxManager::receive(epicsUInt8* raw,unsigned int usedlen)
         return;
     }
 
+    epicsTimeGetCurrent(&buf->rxtime);
+
     {
         SCOPED_LOCK(guard);
         ellAdd(&usedbufs, &buf->node);
@@ -162,23 +203,83 @@ bufRxManager::received(CALLBACK* cb)
         if (!node)
             break;
         buffer *buf=CONTAINER(node, buffer, node);
+        // reference held during dispatch.  Listeners may add more.
+        buf->refs=1;
+
+        // receive() never queues an empty buffer
+        const epicsUInt8 proto=buf->data[0];
+        ELLLIST& specific=self.byproto[proto];
+
+        self.protoCount[proto]++;
+        if(ellCount(&specific)==0 && ellCount(&self.dispatch)==0)
+            self.protoDrop[proto]++;
 
         G.unlock();
 
-        for(ELLNODE *cur=ellFirst(&self.dispatch); cur; cur=ellNext(cur)) {
-            listener *action=CONTAINER(cur, listener, node);
-            if(evrMrmSeqRxDebug>=3) {
-                errlogPrintf("buffer listener %p\n", action);
-            }
-            (action->fn)(action->fnarg, 0, buf->used, buf->data);
-        }
+        dispatchList(specific, buf->used, buf->data);
+        dispatchList(self.dispatch, buf->used, buf->data);
 
         G.lock();
 
-        ellAdd(&self.freebufs, &buf->node);
+        self.unref(buf);
     };
 }
 
+void
+bufRxManager::dispatchList(ELLLIST& list, epicsUInt32 len, const epicsUInt8 *data)
+{
+    for(ELLNODE *cur=ellFirst(&list); cur; cur=ellNext(cur)) {
+        listener *action=CONTAINER(cur, listener, node);
+        if(evrMrmSeqRxDebug>=3) {
+            errlogPrintf("buffer listener %p\n", action);
+        }
+        (action->fn)(action->fnarg, 0, len, data);
+    }
+}
+
+void
+bufRxManager::unref(buffer *buf)
+{
+    if(buf->refs==0)
+        throw std::logic_error("bufRxManager buffer reference underflow");
+    if(--buf->refs==0)
+        release(buf);
+}
+
+void
+bufRxManager::release(buffer *buf)
+{
+    if(buf->rxtime.secPastEpoch) {
+        epicsTimeStamp now;
+        epicsTimeGetCurrent(&now);
+        // exponential moving average
+        residency += (epicsTimeDiffInSeconds(&now, &buf->rxtime) - residency)/16.0;
+    }
+    ninuse--;
+    ellAdd(&freebufs, &buf->node);
+}
+
+bool
+bufRxManager::dataRxRetain(const epicsUInt8 *raw)
+{
+    buffer *buf=fromData(raw);
+
+    SCOPED_LOCK(guard);
+    if(buf->refs==0)
+        throw std::logic_error("bufRxManager can only retain a buffer during dispatch");
+    buf->refs++;
+    return true;
+}
+
+void
+bufRxManager::dataRxRelease(const epicsUInt8 *raw)
+{
+    buffer *buf=fromData(raw);
+
+    SCOPED_LOCK(guard);
+    unref(buf);
+}
+
 void
 bufRxManager::dataRxError(dataBufComplete fn, void* arg)
 {
@@ -188,13 +289,13 @@ bufRxManager::dataRxError(dataBufComplete fn, void* arg)
 }
 
 void
-bufRxManager::dataRxAddReceive(dataBufComplete fn,void* arg)
+bufRxManager::addListener(ELLLIST& list, dataBufComplete fn, void* arg)
 {
     listener *l;
 
     SCOPED_LOCK(guard);
 
-    for(ELLNODE *node=ellFirst(&dispatch); node; node=ellNext(node))
+    for(ELLNODE *node=ellFirst(&list); node; node=ellNext(node))
     {
         l=CONTAINER(node, listener, node);
         // Don't add duplicates
@@ -207,23 +308,93 @@ bufRxManager::dataRxAddReceive(dataBufComplete fn,void* arg)
     l->fn=fn;
     l->fnarg=arg;
 
-    ellAdd(&dispatch, &l->node);
+    ellAdd(&list, &l->node);
 }
 
 void
-bufRxManager::dataRxDeleteReceive(dataBufComplete fn,void* arg)
+bufRxManager::delListener(ELLLIST& list, dataBufComplete fn, void* arg)
 {
     listener *l;
 
     SCOPED_LOCK(guard);
 
-    for(ELLNODE *node=ellFirst(&dispatch); node; node=ellNext(node))
+    for(ELLNODE *node=ellFirst(&list); node; node=ellNext(node))
     {
         l=CONTAINER(node, listener, node);
         if (l->fn==fn && l->fnarg==arg) {
-            ellDelete(&dispatch, node);
+            ellDelete(&list, node);
             delete l;
             return;
         }
     }
 }
+
+void
+bufRxManager::dataRxAddReceive(dataBufComplete fn,void* arg)
+{
+    addListener(dispatch, fn, arg);
+}
+
+void
+bufRxManager::dataRxDeleteReceive(dataBufComplete fn,void* arg)
+{
+    delListener(dispatch, fn, arg);
+}
+
+void
+bufRxManager::dataRxAddReceive(epicsUInt8 proto, dataBufComplete fn,void* arg)
+{
+    addListener(byproto[proto], fn, arg);
+}
+
+void
+bufRxManager::dataRxDeleteReceive(epicsUInt8 proto, dataBufComplete fn,void* arg)
+{
+    delListener(byproto[proto], fn, arg);
+}
+
+epicsUInt32
+bufRxManager::dataRxProtoCount(epicsUInt32 *arr, epicsUInt32 count) const
+{
+    SCOPED_LOCK(guard);
+    count = std::min(count, (epicsUInt32)NELEMENTS(protoCount));
+    std::copy(protoCount, protoCount+count, arr);
+    return count;
+}
+
+epicsUInt32
+bufRxManager::dataRxProtoDrop(epicsUInt32 *arr, epicsUInt32 count) const
+{
+    SCOPED_LOCK(guard);
+    count = std::min(count, (epicsUInt32)NELEMENTS(protoDrop));
+    std::copy(protoDrop, protoDrop+count, arr);
+    return count;
+}
+
+epicsUInt32
+bufRxManager::dataRxPoolSize() const
+{
+    SCOPED_LOCK(guard);
+    return nbufs;
+}
+
+epicsUInt32
+bufRxManager::dataRxPoolHWM() const
+{
+    SCOPED_LOCK(guard);
+    return inuseHWM;
+}
+
+epicsUInt32
+bufRxManager::dataRxPoolDrop() const
+{
+    SCOPED_LOCK(guard);
+    return pooldrop;
+}
+
+double
+bufRxManager::dataRxResidency() const
+{
+    SCOPED_LOCK(guard);
+    return residency;
+}
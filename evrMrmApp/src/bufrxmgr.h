@@ -24,7 +24,14 @@
 class epicsShareClass bufRxManager : public dataBufRx
 {
 public:
-    bufRxManager(const std::string&, unsigned int qdepth, unsigned int bsize=0);
+    /**
+     *@param qdepth Number of Rx buffers allocated initially
+     *@param bsize Size of each buffer.  Zero for 2048 bytes
+     *@param maxdepth If greater than qdepth, allocate more buffers
+     *                on demand up to this number.
+     */
+    bufRxManager(const std::string&, unsigned int qdepth, unsigned int bsize=0,
+                 unsigned int maxdepth=0);
 
     virtual ~bufRxManager();
 
@@ -44,9 +51,8 @@ public:
      */
     virtual void dataRxError(dataBufComplete, void*) OVERRIDE FINAL;
 
-    /**@brief Register to receive data buffers
+    /**@brief Register to receive all data buffers
      *
-     *@param id Receive buffers with this Protocol ID.
      *@param fptr[in] Function pointer invoken after Rx
      *@param arg[in] Arbitrary pointer passed to completion function
      */
@@ -56,8 +62,29 @@ public:
      */
     virtual void dataRxDeleteReceive(dataBufComplete fptr, void* arg=0) OVERRIDE FINAL;
 
+    /**@brief Register to receive data buffers
+     *
+     *@param proto Receive buffers with this Protocol ID.
+     *@param fptr[in] Function pointer invoken after Rx
+     *@param arg[in] Arbitrary pointer passed to completion function
+     */
+    virtual void dataRxAddReceive(epicsUInt8 proto, dataBufComplete fptr, void* arg=0) OVERRIDE FINAL;
+
+    virtual void dataRxDeleteReceive(epicsUInt8 proto, dataBufComplete fptr, void* arg=0) OVERRIDE FINAL;
+
+    virtual epicsUInt32 dataRxProtoCount(epicsUInt32 *arr, epicsUInt32 count) const OVERRIDE FINAL;
+    virtual epicsUInt32 dataRxProtoDrop(epicsUInt32 *arr, epicsUInt32 count) const OVERRIDE FINAL;
+
+    virtual epicsUInt32 dataRxPoolSize() const OVERRIDE FINAL;
+    virtual epicsUInt32 dataRxPoolHWM() const OVERRIDE FINAL;
+    virtual epicsUInt32 dataRxPoolDrop() const OVERRIDE FINAL;
+    virtual double dataRxResidency() const OVERRIDE FINAL;
+
+    virtual bool dataRxRetain(const epicsUInt8 *buf) OVERRIDE FINAL;
+    virtual void dataRxRelease(const epicsUInt8 *buf) OVERRIDE FINAL;
+
 private:
-    epicsMutex guard;
+    mutable epicsMutex guard;
 
     struct listener {
         ELLNODE node;
@@ -65,7 +92,18 @@ private:
         dataBufComplete fn;
         void *fnarg;
     };
+    //! Listeners for all buffers
     ELLLIST dispatch;
+    //! Listeners indexed by Protocol ID (first byte)
+    ELLLIST byproto[256];
+
+    //! Guarded by 'guard'
+    epicsUInt32 protoCount[256];
+    epicsUInt32 protoDrop[256];
+
+    void addListener(ELLLIST& list, dataBufComplete fn, void* arg);
+    void delListener(ELLLIST& list, dataBufComplete fn, void* arg);
+    static void dispatchList(ELLLIST& list, epicsUInt32 len, const epicsUInt8 *data);
 
     dataBufComplete onerror;
     void* onerror_arg;
@@ -83,10 +121,32 @@ private:
     struct buffer {
         ELLNODE node;
         unsigned int used;
+        //! Guarded by 'guard'.  Returned to freebufs when this reaches zero
+        unsigned int refs;
+        //! When queued by receive()
+        epicsTimeStamp rxtime;
         epicsUInt8 data[1]; //!< Actual length is bsize
     };
+    static buffer* fromData(const epicsUInt8* raw)
+    {
+        /* CONTAINER doesn't work when the member is a pointer
+         * because the GNU version's check isn't correct
+         */
+        return (buffer*)((char*)(raw) - offsetof(buffer, data));
+    }
+    // Caller must hold 'guard'
+    void unref(buffer *buf);
+    // Caller must hold 'guard'
+    void release(buffer *buf);
+    buffer* allocBuffer() const;
 
     const unsigned int m_bsize;
+    const unsigned int m_maxdepth;
+
+    // Pool statistics.  Guarded by 'guard'
+    unsigned int nbufs, ninuse, inuseHWM;
+    epicsUInt32 pooldrop;
+    double residency;
 };
 
 #endif // BUFRXMGR_H_INC
@@ -122,29 +122,35 @@ void DelayModule::setDelay(bool output0, bool output1, epicsUInt16 value0, epics
             dly1_ = value1;
         }
 
+        // Prepare gpio mask before sending the data. Allways use mask so we don't ruin data on other GPIO pins.
+        // Each frame ends with the serial pins cleared, so this is read only once.
+        epicsUInt32 gpio = gpio_->getOutput() & ~(SERIAL_DATA_BIT(N_) | SERIAL_CLOCK_BIT(N_) | TRANSFER_LATCH_CLOCK_BIT(N_));
+
+        // 3 frames of 24 bits, 3 writes per bit, and 2 to latch
+        mrf::RegBatch batch(gpio_->regs(), 0, 3*(24*3+2));
+
         // we output the data, set the latches and output the data again. This is to ensure that the delay values are stable when we latch them.
-        pushData(delay);
-        pushData(delay | latch);
-        pushData(delay);
+        pushData(batch, gpio, delay);
+        pushData(batch, gpio, delay | latch);
+        pushData(batch, gpio, delay);
+
+        batch.flush();
     }
 }
 
-void DelayModule::pushData(epicsUInt32 data){
-    epicsUInt32 bit, gpio;
+void DelayModule::pushData(mrf::RegBatch& batch, epicsUInt32 gpio, epicsUInt32 data){
+    epicsUInt32 bit;
     epicsUInt8 i;
 
-    // Prepare gpio mask before sending the data. Allways use mask so we don't ruin data on other GPIO pins.
-    gpio = gpio_->getOutput() & ~(SERIAL_DATA_BIT(N_) | SERIAL_CLOCK_BIT(N_) | TRANSFER_LATCH_CLOCK_BIT(N_));
-
     for( i = 24; i; i-- ){
         bit = 0;
         if(data & 0x00800000) bit = SERIAL_DATA_BIT(N_);
-        gpio_->setOutput(gpio | bit);
-        gpio_->setOutput(gpio | bit | SERIAL_CLOCK_BIT(N_));
-        gpio_->setOutput(gpio | bit);
+        gpio_->setOutput(batch, gpio | bit);
+        gpio_->setOutput(batch, gpio | bit | SERIAL_CLOCK_BIT(N_));
+        gpio_->setOutput(batch, gpio | bit);
         data <<= 1;
     }
     // finish the transmission. A rising edge on LCLK transfers the data from the shift register to the actual delay chips
-    gpio_->setOutput(gpio | TRANSFER_LATCH_CLOCK_BIT(N_));
-    gpio_->setOutput(gpio);
+    gpio_->setOutput(batch, gpio | TRANSFER_LATCH_CLOCK_BIT(N_));
+    gpio_->setOutput(batch, gpio);
 }
@@ -84,10 +84,12 @@ private:
     void setDelay(bool output0, bool output1, epicsUInt16 value0, epicsUInt16 value1);
 
     /**
-     * @brief pushData Writes the data to the module bit by bit
+     * @brief pushData Queues writes of the data to the module bit by bit
+     * @param batch Writes are added to this
+     * @param gpio Current GPIO output, with the serial pins of this module cleared
      * @param data The data to be written
      */
-    void pushData(epicsUInt32 data);
+    void pushData(mrf::RegBatch& batch, epicsUInt32 gpio, epicsUInt32 data);
 
     // There is no locking needed, but methods must be present since there are virtual in mrf::Object class
     virtual void lock() const {}
@@ -170,4 +170,21 @@ epicsStatus mrmBufRegCallback(mrmBufferInfo *data, mrmBufRecievedCallback callba
     return 0;
 }
 
+epicsStatus mrmBufRegProtoCallback(mrmBufferInfo *data, epicsUInt8 proto, mrmBufRecievedCallback callback, void * pass) {
+
+    if(!data->bufRx) {
+        errlogPrintf("mrmBufRegProtoCallback: ERROR: receive structure not initialized!\n");
+        return -1;
+    }
+
+    try {
+        data->bufRx->dataRxAddReceive(proto, callback, pass);
+    } catch(std::exception &e) {
+        errlogPrintf("mrmBufRegProtoCallback: EXCEPTION: %s\n", e.what());
+        return -1;
+    }
+
+    return 0;
+}
+
 } /* extern "C" */
@@ -135,6 +135,20 @@ epicsStatus epicsShareFunc mrmBufSend(mrmBufferInfo_t *data, epicsUInt32 len, ep
  */
 epicsStatus epicsShareFunc mrmBufRegCallback(mrmBufferInfo_t *data, mrmBufRecievedCallback callback, void *param);
 
+/**
+ * @brief Register data receive callback function for one Protocol ID
+ *
+ * The callback is only run for buffers whose first byte is 'proto'.
+ *
+ * @param data      The buffer information data structure
+ * @param proto     Protocol ID
+ * @param callback  Callback function to be registered
+ * @param param     Parameter which is passed to the calllback when it is executed
+ *
+ * @return Returns 0 on success -1 on failure.
+ */
+epicsStatus epicsShareFunc mrmBufRegProtoCallback(mrmBufferInfo_t *data, epicsUInt8 proto, mrmBufRecievedCallback callback, void *param);
+
 #ifdef __cplusplus
 }
 #endif
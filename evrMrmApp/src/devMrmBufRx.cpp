@@ -26,6 +26,8 @@
 #include <waveformRecord.h>
 #include <menuFtype.h>
 #include <callback.h>
+#include <dbScan.h>
+#include <epicsVersion.h>
 
 // for htons() et al.
 #ifdef _WIN32
@@ -42,12 +44,29 @@
 #include "linkoptions.h"
 #include "devObj.h"
 
+// scanOnce() returns non-zero when its queue is full
+#if EPICS_VERSION_INT>=VERSION_INT(3,15,0,2)
+#  define HAVE_SCANONCE_STATUS
+#endif
+
+// recGblSetSevrMsg()
+#if EPICS_VERSION_INT>=VERSION_INT(7,0,6,0)
+#  define HAVE_SEVR_MSG
+#endif
 
 /**
  * Note on record scanning.
  *
  * In order to avoid making more copies of each data buffer this record is manually
- * processed from the Rx callback instead of using normal I/O Intr scanning.
+ * processed instead of using normal I/O Intr scanning.
+ * By default the record is processed from the Rx callback.
+ *
+ * With the link option "Defer=1", and if the receiver can retain buffers,
+ * the Rx callback only keeps a reference and the record is processed later
+ * with scanOnce().  A newer buffer replaces one which has not yet been processed.
+ * If the scanOnce() queue is full the buffer is dropped, and the next one
+ * is queued again.  Replaced and dropped buffers are counted, and the next
+ * processing raises a READ alarm, with the counts as message (Base >= 7.0.6).
  */
 
 static
@@ -60,11 +79,20 @@ struct s_priv
   epicsUInt32 proto16;
   epicsUInt32 proto32;
   char prop[20];
+  epicsUInt32 defer;
 
   dataBufRx *priv;
 
   epicsUInt32 blen;
   const epicsUInt8* buf;
+
+  // Received, waiting for scanOnce().  Guarded by record lock
+  dataBufRxRef pending;
+  // # of pending buffers replaced before being processed,
+  // or dropped as scanOnce() queue was full.  Guarded by record lock
+  epicsUInt32 nreplaced, nnotqueued;
+  // some were, since last processed.  Guarded by record lock
+  bool replaced;
 };
 
 static const
@@ -75,9 +103,27 @@ linkOptionDef eventdef[] =
   linkInt32   (s_priv, proto16, "Proto16", 0, 0),
   linkInt32   (s_priv, proto32, "Proto32", 0, 0),
   linkString  (s_priv, prop , "P", 1, 0),
+  linkInt32   (s_priv, defer, "Defer", 0, 0),
   linkOptionEnd
 };
 
+/* Listeners are registered with the first byte of the Protocol ID.
+ * The full 16 or 32 bit ID is checked in datarx().
+ * Returns false to receive all buffers.
+ */
+static bool firstProtoByte(const s_priv *paddr, epicsUInt8 *id)
+{
+  if (paddr->proto != 0xff00)
+    *id = paddr->proto&0xff;
+  else if (paddr->proto16)
+    *id = (paddr->proto16>>8)&0xff;
+  else if (paddr->proto32)
+    *id = (paddr->proto32>>24)&0xff;
+  else
+    return false;
+  return true;
+}
+
 static long add_record_waveform(dbCommon *praw)
 {
   waveformRecord *prec=(waveformRecord*)praw;
@@ -92,6 +138,10 @@ try {
   paddr->proto = 0xff00;
   paddr->proto16 = 0;
   paddr->proto32 = 0;
+  paddr->defer = 0;
+  paddr->nreplaced = 0;
+  paddr->nnotqueued = 0;
+  paddr->replaced = false;
 
   if (linkOptionsStore(eventdef, paddr.get(), prec->inp.value.instio.string, 0))
     throw std::runtime_error("Couldn't parse link string");
@@ -105,7 +155,11 @@ try {
   if(!paddr->priv)
     throw std::runtime_error("Failed to lookup device");
 
-  paddr->priv->dataRxAddReceive(datarx, praw);
+  epicsUInt8 id;
+  if (firstProtoByte(paddr.get(), &id))
+    paddr->priv->dataRxAddReceive(id, datarx, praw);
+  else
+    paddr->priv->dataRxAddReceive(datarx, praw);
 
   // prec->dpvt is set again to indicate
   // This also serves to indicate successful
@@ -133,7 +187,11 @@ static long del_record_waveform(dbCommon *praw)
         mrf::auto_ptr<s_priv> paddr(static_cast<s_priv*>(praw->dpvt));
         praw->dpvt = 0;
 
-        paddr->priv->dataRxDeleteReceive(datarx, praw);
+        epicsUInt8 id;
+        if (firstProtoByte(paddr.get(), &id))
+            paddr->priv->dataRxDeleteReceive(id, datarx, praw);
+        else
+            paddr->priv->dataRxDeleteReceive(datarx, praw);
 
     } catch(std::runtime_error& e) {
         recGblRecordError(S_dev_noDevice, (void*)praw, e.what());
@@ -164,6 +222,37 @@ void datarx(void *arg, epicsStatus ok,
         paddr->buf=NULL;
         paddr->blen=0;
     } else {
+        dataBufRxRef ref;
+        if(paddr->defer) {
+            dataBufRxRef temp(paddr->priv, len, buf);
+            ref.swap(temp);
+        }
+        if(ref.data()) {
+            bool queued = paddr->pending.data()!=NULL;
+            if(queued) {
+                paddr->nreplaced++;
+                paddr->replaced = true;
+            }
+            // any older unprocessed buffer is released with 'ref'
+            paddr->pending.swap(ref);
+            dbScanUnlock((dbCommon*)prec);
+
+            if(!queued) {
+#ifdef HAVE_SCANONCE_STATUS
+                if(scanOnce((dbCommon*)prec)) {
+                    // queue full.  Drop, so that the next buffer is queued again
+                    dbScanLock((dbCommon*)prec);
+                    paddr->pending.reset();
+                    paddr->nnotqueued++;
+                    paddr->replaced = true;
+                    dbScanUnlock((dbCommon*)prec);
+                }
+#else
+                scanOnce((dbCommon*)prec);
+#endif
+            }
+            return;
+        }
         paddr->buf=buf;
         paddr->blen=len;
     }
@@ -180,9 +269,27 @@ void datarx(void *arg, epicsStatus ok,
 static long write_waveform(waveformRecord* prec)
 {
   if (!prec->dpvt) {(void)recGblSetSevr(prec, COMM_ALARM, INVALID_ALARM); return -1; }
-try {
   s_priv *paddr=static_cast<s_priv*>(prec->dpvt);
 
+  // processed by scanOnce().  Released on return
+  dataBufRxRef ref;
+  if (!paddr->buf && paddr->pending.data()) {
+      ref.swap(paddr->pending);
+      paddr->buf=ref.data();
+      paddr->blen=ref.size();
+  }
+try {
+  if (paddr->replaced) {
+      // some buffers were not processed
+      paddr->replaced = false;
+#ifdef HAVE_SEVR_MSG
+      (void)recGblSetSevrMsg(prec, READ_ALARM, MINOR_ALARM, "%u replaced, %u not queued",
+                             (unsigned)paddr->nreplaced, (unsigned)paddr->nnotqueued);
+#else
+      (void)recGblSetSevr(prec, READ_ALARM, MINOR_ALARM);
+#endif
+  }
+
   if (!paddr->buf) {
       // Error condition set INVALID_ALARM
       (void)recGblSetSevr(prec, READ_ALARM, MAJOR_ALARM);
@@ -225,8 +332,17 @@ try {
       prec->nord = paddr->blen/dbValueSize(prec->ftvl);
   }
 
+  if (ref.data()) {
+      paddr->buf=NULL;
+      paddr->blen=0;
+  }
+
   return 0;
 } catch(std::exception& e) {
+  if (ref.data()) {
+      paddr->buf=NULL;
+      paddr->blen=0;
+  }
   recGblRecordError(S_db_noMemory, (void*)prec, e.what());
   return S_db_noMemory;
 }
@@ -21,6 +21,7 @@
 #include <epicsMath.h>
 #include <dbDefs.h>
 #include <dbScan.h>
+#include <dbAccess.h>
 #include <epicsInterrupt.h>
 
 #include "mrmDataBufTx.h"
@@ -58,13 +59,33 @@
 #  define HAVE_PARALLEL_CB
 #endif
 
+/* whether epicsMonotonicGet() is available to extrapolate
+ * the current time between seconds ticks, and to time
+ * the "Done" latency histogram.
+ */
+#if EPICS_VERSION_INT>=VERSION_INT(3,16,1,0)
+#  define HAVE_TS_EXTRAPOLATE
+#endif
+
 int evrMrmTimeDebug;
 int evrMrmSeqRxDebug;
 //! value in nanoseconds above which a timestamp is considered invalid.
 //! below is truncated.  May be necessary when simulating timestamp
 //! source in software
 int evrMrmTimeNSOverflowThreshold;
+//! non-zero to serve the current time by extrapolating from the
+//! time latched at each seconds tick with the CPU monotonic clock.
+int evrMrmTimeExtrapolate;
+//! largest extrapolation error (ns), as measured at the following tick,
+//! before falling back to latching on each request.
+int evrMrmTimeExtrapolateMaxNS = 1000;
+//! non-zero to commit deferred mapping RAM changes by writing the
+//! inactive RAM, then switching.  Otherwise the active RAM is written.
+int evrMrmMapBankSwitch = 1;
 extern "C" {
+ epicsExportAddress(int, evrMrmMapBankSwitch);
+ epicsExportAddress(int, evrMrmTimeExtrapolate);
+ epicsExportAddress(int, evrMrmTimeExtrapolateMaxNS);
  epicsExportAddress(int, evrMrmSeqRxDebug);
  epicsExportAddress(int, evrMrmTimeDebug);
  epicsExportAddress(int, evrMrmTimeNSOverflowThreshold);
@@ -104,10 +125,40 @@ extern "C" {
      * Set to 0.0 to disable
      *
      * No point in making this shorter than the system tick
+     *
+     * This is now the default maximum holdoff, and
+     * may be changed later for each EVR ("FIFO Holdoff Max").
+     * The actual sleep adapts to the number of events
+     * found in the FIFO.  cf. EVRMRM::fifoHoldoffNext()
      */
     double mrmEvrFIFOPeriod = 1.0/ 1000.0; /* 1/rate in Hz */
 
     epicsExportAddress(double,mrmEvrFIFOPeriod);
+
+    /* When non-zero, EVRs created afterwards decouple reading
+     * the FIFO from dispatching events.  The FIFO thread
+     * copies entries into a lock-free ring without taking
+     * the EVR lock, and a second thread ("EVRDISP") runs
+     * the per-event actions.  Property access then waits for
+     * at most one event to be dispatched, instead of for a whole
+     * burst of bus reads.
+     */
+    int mrmEvrFIFORing = 0;
+
+    epicsExportAddress(int,mrmEvrFIFORing);
+
+    /* Data buffer Rx pool of EVRs created afterwards.
+     * Depth buffers of Size bytes (0 for 2048) are allocated
+     * at setup.  If MaxDepth is greater than Depth, then more are
+     * allocated on demand instead of dropping received buffers.
+     */
+    int mrmEvrBufRxDepth = 10;
+    int mrmEvrBufRxSize = 0;
+    int mrmEvrBufRxMaxDepth = 0;
+
+    epicsExportAddress(int,mrmEvrBufRxDepth);
+    epicsExportAddress(int,mrmEvrBufRxSize);
+    epicsExportAddress(int,mrmEvrBufRxMaxDepth);
 }
 
 /* Number of good updates before the time is considered valid */
@@ -128,11 +179,15 @@ EVRMRM::EVRMRM(const std::string& n,
   ,conf(c)
   ,base(b)
   ,baselen(bl)
+  ,shadow(n, b, bl, evrLock)
   ,buftx(n+":BUFTX", b+U32_DataTxCtrl, b+U32_DataTx_base)
-  ,bufrx(n+":BUFRX", b, 10) // Sets depth of Rx queue
+  ,bufrx(n+":BUFRX", b, std::max(1, mrmEvrBufRxDepth), std::max(0, mrmEvrBufRxSize),
+         std::max(0, mrmEvrBufRxMaxDepth))
   ,count_recv_error(0)
   ,count_hardware_irq(0)
   ,count_heartbeat(0)
+  ,count_fifo_ring_drop(0)
+  ,count_fifo_reads(0)
   ,shadowIRQEna(0)
   ,count_FIFO_overflow(0)
   ,outputs()
@@ -146,6 +201,14 @@ EVRMRM::EVRMRM(const std::string& n,
                    epicsThreadPriorityHigh )
   // 3 because 2 IRQ events, and 1 shutdown event
   ,drain_fifo_wakeup(3,sizeof(int))
+  ,useFIFORing(mrmEvrFIFORing!=0)
+  ,dispatch_fifo_method(*this)
+  ,dispatch_fifo_stop(false)
+  ,fifoHoldoff(0.0)
+  ,fifoHoldoffMax_(mrmEvrFIFOPeriod)
+  ,fifoBatchTarget_(8)
+  ,latencyEna(false)
+  ,latencySel(0)
   ,count_FIFO_sw_overrate(0)
   ,timeSrcMode(Disable)
   ,stampClock(0.0)
@@ -154,6 +217,13 @@ EVRMRM::EVRMRM(const std::string& n,
   ,timestampValid(0)
   ,lastInvalidTimestamp(0)
   ,lastValidTimestamp(0)
+  ,tsxValid(false)
+  ,tsxMono(0u)
+  ,tsxError(0.0)
+  ,count_tsx(0)
+  ,count_tsx_fallback(0)
+  ,mapBank(0)
+  ,mapDeferCnt(0)
 {
 try{
     const epicsUInt32 rawver = fpgaFirmware();
@@ -211,7 +281,7 @@ try{
     for(size_t i=0; i<conf->nIFP; i++){
         std::ostringstream name;
         name<<n<<":FPIn"<<i;
-        inputs[i]=new MRMInput(name.str(), base,i);
+        inputs[i]=new MRMInput(name.str(), shadow,i);
     }
 
     // Special output for mapping bus interrupt
@@ -252,7 +322,7 @@ try{
     for(size_t i=0; i<conf->nPS; i++){
         std::ostringstream name;
         name<<n<<":PS"<<i;
-        prescalers[i]=new MRMPreScaler(name.str(), *this,base+U32_Scaler(i));
+        prescalers[i]=new MRMPreScaler(name.str(), *this,shadow,U32_Scaler(i));
     }
 
     pulsers.resize(32);
@@ -306,6 +376,8 @@ try{
         printf("CML outputs not supported with this firmware\n");
     }
 
+    cacheRegisters();
+
     for(epicsUInt32 i=0; i<NELEMENTS(this->events); i++) {
         events[i].code=i;
         events[i].owner=this;
@@ -315,16 +387,13 @@ try{
     SCOPED_LOCK(evrLock);
 
     memset(_mapped, 0, sizeof(_mapped));
-    // restore mapping ram to a clean state
-    // needed when the IOC is started w/o a device reset (ie Linux)
-    //TODO: find a way to do this that doesn't require clearing
-    //      mapping which will shortly be set again...
-    for(size_t i=0; i<255; i++) {
-        WRITE32(base, MappingRam(0, i, Internal), 0);
-        WRITE32(base, MappingRam(0, i, Trigger), 0);
-        WRITE32(base, MappingRam(0, i, Set), 0);
-        WRITE32(base, MappingRam(0, i, Reset), 0);
-    }
+    // start from a clean mapping ram
+    // needed when the IOC is started w/o a device reset (ie Linux).
+    // Written with the rest of the initial configuration
+    // when the IOC is running.  cf. mrmEvrInithooks()
+    memset(mapImage, 0, sizeof(mapImage));
+    mapBank = (READ32(base, Control) & Control_mapsel) ? 1 : 0;
+    mapDefer();
 
     // restore default special mappings
     // These may be replaced later
@@ -353,13 +422,28 @@ try{
             shadowSourceTS=TSSourceEvent;
     }
 
+    {
+        SCOPED_LOCK(evrLock);
+        updateTSScale();
+    }
+
     eventNotifyAdd(MRF_EVENT_TS_COUNTER_RST, &seconds_tick, (void*)this);
 
+    if(useFIFORing) {
+        dispatch_fifo_task.reset(new epicsThread(dispatch_fifo_method, "EVRDISP",
+                                                 epicsThreadGetStackSize(epicsThreadStackBig),
+                                                 epicsThreadPriorityHigh));
+        dispatch_fifo_task->start();
+    }
     drain_fifo_task.start();
 
     if(busConfig.busType==busType_pci)
         mrf::SPIDevice::registerDev(n+":FLASH", mrf::SPIDevice(this, 1));
 
+    // created after iocInit(), so mrmEvrInithooks() won't commit
+    if(interruptAccept)
+        mapCommit();
+
 } catch (std::exception& e) {
     printf("Aborting EVR initializtion: %s\n", e.what());
     cleanup();
@@ -378,10 +462,31 @@ void
 EVRMRM::cleanup()
 {
     printf("%s shuting down... ", name().c_str());
+    irqPoller.reset(); // joins
     int wakeup=1;
     drain_fifo_wakeup.send(&wakeup, sizeof(wakeup));
     drain_fifo_task.exitWait();
 
+    if(dispatch_fifo_task.get()) {
+        {
+            SCOPED_LOCK(evrLock);
+            dispatch_fifo_stop = true;
+        }
+        dispatch_fifo_wakeup.signal();
+        dispatch_fifo_task->exitWait();
+    }
+
+    {
+        SCOPED_LOCK(evrLock);
+        for(size_t i=0; i<NELEMENTS(events); i++)
+            events[i].worker = 0;
+    }
+    for(workers_t::iterator it=workers.begin(); it!=workers.end(); ++it)
+    {
+        delete *it; // joins
+    }
+    workers.clear();
+
     for(outputs_t::iterator it=outputs.begin();
         it!=outputs.end(); ++it)
     {
@@ -552,17 +657,79 @@ EVRMRM::specialSetMap(epicsUInt32 code, epicsUInt32 func,bool v)
 
     SCOPED_LOCK(evrLock);
 
-    epicsUInt32 val=READ32(base, MappingRam(0, code, Internal));
-
     if (v == _ismap(code,func-96)) {
         // mapping already set defined
 
     } else if(v) {
         _map(code,func-96);
-        WRITE32(base, MappingRam(0, code, Internal), val|mask);
+        mapModify(code, MapInternal, mask, true);
     } else {
         _unmap(code,func-96);
-        WRITE32(base, MappingRam(0, code, Internal), val&~mask);
+        mapModify(code, MapInternal, mask, false);
+    }
+}
+
+void
+EVRMRM::mapModify(epicsUInt8 evt, mapBlock_t block, epicsUInt32 mask, bool set)
+{
+    SCOPED_LOCK(evrLock);
+
+    epicsUInt32 val = mapImage[evt][block];
+    if(set)
+        val |= mask;
+    else
+        val &= ~mask;
+
+    if(val==mapImage[evt][block])
+        return;
+    mapImage[evt][block] = val;
+
+    if(!mapDeferCnt)
+        WRITE32(base, _MappingRam(mapBank, evt, 4*block), val);
+}
+
+void
+EVRMRM::mapDefer()
+{
+    SCOPED_LOCK(evrLock);
+    mapDeferCnt++;
+}
+
+void
+EVRMRM::mapCommit()
+{
+    SCOPED_LOCK(evrLock);
+
+    if(!mapDeferCnt)
+        throw std::logic_error("mapCommit() without mapDefer()");
+    if(--mapDeferCnt)
+        return;
+
+    if(!evrMrmMapBankSwitch) {
+        mapWrite(mapBank);
+        return;
+    }
+
+    // The inactive RAM may be stale.  Rewrite all, then switch.
+    const unsigned next = mapBank^1u;
+    mapWrite(next);
+
+    if(next)
+        BITSET(NAT,32, base, Control, Control_mapsel);
+    else
+        BITCLR(NAT,32, base, Control, Control_mapsel);
+    mapBank = next;
+}
+
+// caller must hold evrLock
+void
+EVRMRM::mapWrite(unsigned bank)
+{
+    for(unsigned evt=0; evt<NELEMENTS(mapImage); evt++) {
+        WRITE32(base, MappingRam(bank, evt, Internal), mapImage[evt][MapInternal]);
+        WRITE32(base, MappingRam(bank, evt, Trigger),  mapImage[evt][MapTrigger]);
+        WRITE32(base, MappingRam(bank, evt, Set),      mapImage[evt][MapSet]);
+        WRITE32(base, MappingRam(bank, evt, Reset),    mapImage[evt][MapReset]);
     }
 }
 
@@ -595,6 +762,7 @@ EVRMRM::clockSet(double freq)
 
         eventClock=FracSynthAnalyze(READ32(base, FracDiv),
                                     fracref,0)*1e6;
+        updateTSScale();
     }
 
     // USecDiv is accessed as a 32 bit register, but
@@ -698,6 +866,7 @@ EVRMRM::setSourceTS(TSSource src)
     WRITE32(base, CounterPS, div);
     shadowCounterPS=div;
     shadowSourceTS=src;
+    updateTSScale();
 }
 
 double
@@ -739,6 +908,68 @@ EVRMRM::clockTSSet(double clk)
     }
 
     stampClock=clk;
+    updateTSScale();
+}
+
+/* Configuration registers of subunits which are only changed by us.
+ * Record scans of these are served from the shadow.
+ * Pulser control includes the live output readback bit.
+ * Pulser width and prescaler are re-read after each write (cf. MRMPulser),
+ * as not all of their bits are implemented by every pulser.
+ * Other status (eg. mux output state) is never cached.
+ */
+void
+EVRMRM::cacheRegisters()
+{
+    shadow.cache(U32_ScalerN, 4*conf->nPS);
+    shadow.cache(U32_ScalerN+ScalerPhasOffs_offset, 4*conf->nPS);
+
+    for(size_t i=0; i<pulsers.size(); i++) {
+        if(!pulsers[i])
+            continue;
+        // output readback is live in control only
+        shadow.cache(U32_PulserCtrl(i), 4, PulserCtrl_rbv);
+        shadow.cache(U32_PulserScal(i));
+        shadow.cache(U32_PulserDely(i));
+        shadow.cache(U32_PulserWdth(i));
+    }
+
+    // All output mapping registers (FP, FP Univ, RB, and Backplane)
+    shadow.cache(U32_OutputMapFPN, U32_InputMapFPN-U32_OutputMapFPN);
+
+    shadow.cache(U32_InputMapFPN, 4*conf->nIFP);
+
+    for(size_t i=0; i<shortcmls.size(); i++) {
+        if(!shortcmls[i])
+            continue;
+        shadow.cache(U32_OutputCMLCount(i));
+        shadow.cache(U32_GTXDelay(i));
+    }
+}
+
+// caller must hold evrLock
+void
+EVRMRM::updateTSScale()
+{
+    double period=1e9/clockTS(); // in nanoseconds
+    epicsUInt64 scale=0u;
+
+    // limit so that the 32.32 result fits
+    if(period>0 && period<4e9 && isfinite(period))
+        scale=epicsUInt64(period*4294967296.0 + 0.5);
+
+    tsScale.store(scale);
+}
+
+epicsUInt64
+EVRMRM::tsTickScale() const
+{
+    epicsUInt64 scale;
+    if(!tsScale.tryLoad(scale)) {
+        SCOPED_LOCK(evrLock);
+        scale=tsScale.loadExcl();
+    }
+    return scale;
 }
 
 bool
@@ -776,51 +1007,63 @@ EVRMRM::getTimeStamp(epicsTimeStamp *ret,epicsUInt32 event)
 {
     if(!ret) throw std::runtime_error("Invalid argument");
     epicsTimeStamp ts;
+    const bool byevent = event>0 && event<=255;
 
-    SCOPED_LOCK(evrLock);
-    if(timestampValid<TSValidThreshold) return false;
-
-    if(event>0 && event<=255) {
+    if(byevent) {
         // Get time of last event code #
 
         eventCode *entry=&events[event];
 
+        // Without evrLock so as not to wait for the FIFO drain loop
+        if(!entry->last.tryLoad(ts)) {
+            // preempted the writer.  wait for it.
+            SCOPED_LOCK(evrLock);
+            ts = entry->last.loadExcl();
+        }
+
         // Fail if event is not mapped
         if (!entry->interested ||
-            ( entry->last_sec==0 &&
-              entry->last_evt==0) )
+            ( ts.secPastEpoch==0 &&
+              ts.nsec==0) )
         {
             return false;
         }
 
-        ts.secPastEpoch=entry->last_sec;
-        ts.nsec=entry->last_evt;
-
+        // Convert without evrLock when the input passes all of the checks
+        // made by convertTS().  Otherwise fall through to convertTS(),
+        // which applies the side effects of an invalid time.
+        TSState st;
+        if(tsState.tryLoad(st)) {
+            if(st.valid<TSValidThreshold)
+                return false;
 
-    } else {
-        // Get current absolute time
+            epicsUInt64 scale=tsTickScale();
 
-        epicsUInt32 ctrl=READ32(base, Control);
+            if(ts.secPastEpoch!=0 && ts.nsec!=0
+                    && ts.secPastEpoch!=st.lastInvalid
+                    && ts.secPastEpoch<=st.lastValid+1
+                    && scale)
+            {
+                epicsUInt32 nsec=ticks2ns(ts.nsec, scale);
+                if(nsec<1000000000u) {
+                    ret->secPastEpoch=ts.secPastEpoch-POSIX_TIME_AT_EPICS_EPOCH;
+                    ret->nsec=nsec;
+                    return true;
+                }
+            }
+        }
+    }
 
-        // Latch timestamp
-        WRITE32(base, Control, ctrl|Control_tsltch);
+    SCOPED_LOCK(evrLock);
+    if(timestampValid<TSValidThreshold) return false;
 
-        ts.secPastEpoch=READ32(base, TSSecLatch);
-        ts.nsec=READ32(base, TSEvtLatch);
+    if(!byevent) {
+        // Get current absolute time
 
-        /* BUG: There was a firmware bug which occasionally
-         * causes the previous write to fail with a VME bus
-         * error, and 0 the Control register.
-         *
-         * This issues has been fixed in VME firmwares EVRv 5
-         * pre2 and EVG v3 pre2.  Feb 2011
-         */
-        epicsUInt32 ctrl2=READ32(base, Control);
-        if (ctrl2!=ctrl) { // tsltch bit is write-only
-            printf("Get timestamp: control register write fault. Written: %08x, readback: %08x\n",ctrl,ctrl2);
-            WRITE32(base, Control, ctrl);
-        }
+        if(extrapolateTS(ret))
+            return true;
 
+        latchTS(&ts);
     }
 
     if(!convertTS(&ts))
@@ -830,6 +1073,108 @@ EVRMRM::getTimeStamp(epicsTimeStamp *ret,epicsUInt32 event)
     return true;
 }
 
+// caller must hold evrLock.  Returns raw POSIX sec. and ticks
+void
+EVRMRM::latchTS(epicsTimeStamp *ts)
+{
+    epicsUInt32 ctrl=READ32(base, Control);
+
+    // Latch timestamp
+    WRITE32(base, Control, ctrl|Control_tsltch);
+
+    ts->secPastEpoch=READ32(base, TSSecLatch);
+    ts->nsec=READ32(base, TSEvtLatch);
+
+    /* BUG: There was a firmware bug which occasionally
+     * causes the previous write to fail with a VME bus
+     * error, and 0 the Control register.
+     *
+     * This issues has been fixed in VME firmwares EVRv 5
+     * pre2 and EVG v3 pre2.  Feb 2011
+     */
+    epicsUInt32 ctrl2=READ32(base, Control);
+    if (ctrl2!=ctrl) { // tsltch bit is write-only
+        printf("Get timestamp: control register write fault. Written: %08x, readback: %08x\n",ctrl,ctrl2);
+        WRITE32(base, Control, ctrl);
+    }
+}
+
+/* Latch a new reference for extrapolation, and measure how far
+ * off extrapolation from the previous reference would have been.
+ * Called from seconds_tick() with evrLock held, after validity is updated.
+ */
+void
+EVRMRM::sampleTSX()
+{
+#ifdef HAVE_TS_EXTRAPOLATE
+    if(!evrMrmTimeExtrapolate || timestampValid<TSValidThreshold) {
+        tsxValid = false;
+        return;
+    }
+
+    epicsTimeStamp ts;
+    latchTS(&ts);
+    epicsUInt64 mono = epicsMonotonicGet();
+
+    if(!convertTS(&ts)) {
+        tsxValid = false;
+        return;
+    }
+
+    // Only trust extrapolation after one interval has been checked
+    bool ok = false;
+    if(tsxMono) {
+        epicsTimeStamp predict = tsxStamp;
+        epicsTimeAddSeconds(&predict, (mono-tsxMono)*1e-9);
+        tsxError = epicsTimeDiffInSeconds(&ts, &predict)*1e9;
+        ok = fabs(tsxError) <= evrMrmTimeExtrapolateMaxNS;
+    }
+
+    tsxStamp = ts;
+    tsxMono = mono;
+    tsxValid = ok;
+#endif
+}
+
+// caller must hold evrLock and have checked timestampValid
+bool
+EVRMRM::extrapolateTS(epicsTimeStamp *ts)
+{
+#ifdef HAVE_TS_EXTRAPOLATE
+    if(!evrMrmTimeExtrapolate)
+        return false;
+
+    if(tsxValid) {
+        epicsUInt64 age = epicsMonotonicGet()-tsxMono;
+
+        // A seconds tick is overdue.  Don't extrapolate further than was checked.
+        if(age < 1100000000u) {
+            epicsUInt64 nsec = tsxStamp.nsec + age;
+            ts->secPastEpoch = tsxStamp.secPastEpoch + epicsUInt32(nsec/1000000000u);
+            ts->nsec = epicsUInt32(nsec%1000000000u);
+            count_tsx++;
+            return true;
+        }
+        tsxValid = false;
+    }
+    count_tsx_fallback++;
+#else
+    (void)ts;
+#endif
+    return false;
+}
+
+// caller must hold evrLock
+void
+EVRMRM::publishTSState()
+{
+    TSState st;
+    st.valid=timestampValid;
+    st.lastInvalid=lastInvalidTimestamp;
+    st.lastValid=lastValidTimestamp;
+    tsState.store(st);
+}
+
 /** @brief In place conversion between raw posix sec+ticks to EPICS sec+nsec.
  @returns false if conversion failed
  */
@@ -846,6 +1191,7 @@ EVRMRM::convertTS(epicsTimeStamp* ts)
     // recurrence of an invalid time
     if(ts->secPastEpoch==lastInvalidTimestamp) {
         timestampValid=0;
+        publishTSState();
         scanIoRequest(timestampValidChange);
         if(evrMrmTimeDebug>0)
             errlogPrintf("TS convert repeats known bad value new %08x bad %08x\n",
@@ -863,17 +1209,18 @@ EVRMRM::convertTS(epicsTimeStamp* ts)
         errlogPrintf("EVR ignoring invalid TS %08x %08x (expect %08x)\n",
                      ts->secPastEpoch, ts->nsec, lastValidTimestamp);
         timestampValid=0;
+        publishTSState();
         scanIoRequest(timestampValidChange);
         return false;
     }
 
     // Convert ticks to nanoseconds
-    double period=1e9/clockTS(); // in nanoseconds
+    epicsUInt64 scale=tsTickScale();
 
-    if(period<=0 || !isfinite(period))
+    if(!scale)
         return false;
 
-    ts->nsec=(epicsUInt32)(ts->nsec*period);
+    ts->nsec=ticks2ns(ts->nsec, scale);
 
     // 1 sec. reset is late
     if(ts->nsec>=1000000000u) {
@@ -886,6 +1233,7 @@ EVRMRM::convertTS(epicsTimeStamp* ts)
         if(int(ts->nsec-1000000000u)>=evrMrmTimeNSOverflowThreshold) {
             timestampValid=0;
             lastInvalidTimestamp=ts->secPastEpoch;
+            publishTSState();
             scanIoRequest(timestampValidChange);
 
             return false;
@@ -1071,6 +1419,23 @@ OBJECT_BEGIN2(EVRMRM, EVR)
   OBJECT_PROP1("DCTOPID", &EVRMRM::topId);
   OBJECT_PROP2("EvtCode", &EVRMRM::dummy, &EVRMRM::setEvtCode);
   OBJECT_PROP2("TimeSrc", &EVRMRM::timeSrc, &EVRMRM::setTimeSrc);
+  OBJECT_PROP1("FIFO Ring Drop", &EVRMRM::FIFORingDrop);
+  OBJECT_PROP1("Worker Drop", &EVRMRM::workerDrop);
+  OBJECT_PROP1("FIFO Read Count", &EVRMRM::FIFOReadCount);
+  OBJECT_PROP1("IRQ Poll Count", &EVRMRM::IRQPollCount);
+  OBJECT_PROP1("IRQ Poll Loop Time", &EVRMRM::IRQPollLoopTime);
+  OBJECT_PROP1("TSX Count", &EVRMRM::TSXCount);
+  OBJECT_PROP1("TSX Fallback Count", &EVRMRM::TSXFallbackCount);
+  OBJECT_PROP1("TSX Error", &EVRMRM::TSXError);
+  OBJECT_PROP1("FIFO Holdoff", &EVRMRM::FIFOHoldoff);
+  OBJECT_PROP2("FIFO Holdoff Max", &EVRMRM::FIFOHoldoffMax, &EVRMRM::setFIFOHoldoffMax);
+  OBJECT_PROP2("FIFO Batch Target", &EVRMRM::FIFOBatchTarget, &EVRMRM::setFIFOBatchTarget);
+  OBJECT_PROP2("Latency Enable", &EVRMRM::latencyEnabled, &EVRMRM::latencyEnable);
+  OBJECT_PROP2("Latency Code", &EVRMRM::latencyCode, &EVRMRM::setLatencyCode);
+  OBJECT_PROP1("Latency Drain", &EVRMRM::latencyDrain);
+  OBJECT_PROP1("Latency Done", &EVRMRM::latencyDone);
+  OBJECT_PROP1("Latency Bins", &EVRMRM::latencyBins);
+  OBJECT_PROP1("Latency Reset", &EVRMRM::latencyReset);
     {
       std::string (EVRMRM::*getter)() const = &EVRMRM::nextSecond;
       OBJECT_PROP1("NextSecond", getter);
@@ -1091,7 +1456,8 @@ EVRMRM::enableIRQ(void)
 {
     interruptLock I;
 
-    shadowIRQEna =  IRQ_Enable
+    // When polled, flags are still latched, but no interrupt is raised
+    shadowIRQEna =  (irqPoller.get() ? 0 : IRQ_Enable)
                    |IRQ_RXErr    |IRQ_BufFull
                    |IRQ_Heartbeat
                    |IRQ_Event    |IRQ_FIFOFull
@@ -1129,6 +1495,10 @@ void
 EVRMRM::isr_poll(void *arg) {
     EVRMRM *evr=static_cast<EVRMRM*>(arg);
 
+    // Nothing pending.  Skip the flag and enable writes of isr()
+    if(!(READ32(evr->base, IRQFlag)&evr->shadowIRQEna))
+        return;
+
     // Calling the default platform-independent interrupt routine
     evr->isr(evr, true);
 }
@@ -1220,6 +1590,21 @@ static
 void
 eventInvoke(eventCode& event)
 {
+    if(event.worker) {
+        for(eventCode::notifiees_t::const_iterator it=event.notifiees.begin();
+            it!=event.notifiees.end();
+            ++it)
+        {
+            (*it->first)(it->second, event.code);
+        }
+
+        // scans for all priorities are run by the worker
+        event.waitingfor=1;
+        if(!event.worker->queue(&event))
+            event.waitingfor=0; // dropped.  counted by the worker
+        return;
+    }
+
 #ifdef HAVE_PARALLEL_CB
     // bit mask of priorities for which scans have been queued
     unsigned prio_queued =
@@ -1272,23 +1657,35 @@ EVRMRM::drain_fifo()
             break;
         }
 
-        guard.lock();
-
         count_fifo_loops++;
 
         epicsUInt32 status;
 
+        // In ring mode the FIFO is read without evrLock
+        // and dispatch_fifo() takes the host time for each entry.
+        epicsTimeStamp now;
+        if(!useFIFORing) {
+            latencyNow(&now);
+            guard.lock();
+        }
+
+        /* IRQFlag is sampled only before and after each batch.
+         * An empty FIFO reads back code 0, so there is no need to
+         * test IRQ_Event before each entry.
+         *
+         * Reading EvtFIFOCode pops the FIFO and latches the matching
+         * EvtFIFOSec/EvtFIFOEvt, so these can't be fetched together
+         * as one ascending burst.  3 reads per event is the minimum.
+         */
+        status=READ32(base, IRQFlag);
+        epicsUInt32 nreads=1;
+
         // Bound the number of events taken from the FIFO
         // at one time.
-        for(i=0; i<512; i++) {
-
-            status=READ32(base, IRQFlag);
-            if (!(status&IRQ_Event))
-                break;
-            if (status&IRQ_RXErr)
-                break;
+        for(i=0; (status&IRQ_Event) && !(status&IRQ_RXErr) && i<512; i++) {
 
             epicsUInt32 code=READ32(base, EvtFIFOCode);
+            nreads++;
             if (!code)
                 break;
 
@@ -1296,6 +1693,7 @@ EVRMRM::drain_fifo()
                 // BUG: we get occasional corrupt VME reads of this register
                 // Fixed in firmware.  Feb 2011
                 epicsUInt32 code2=READ32(base, EvtFIFOCode);
+                nreads++;
                 if (code2>NELEMENTS(events)) {
                     printf("Really weird event 0x%08x 0x%08x\n", code, code2);
                     break;
@@ -1306,60 +1704,35 @@ EVRMRM::drain_fifo()
 
             count_fifo_events++;
 
-            eventCode& evt = events[code];
-
-            // cache of last time
-            evt.last_sec=READ32(base, EvtFIFOSec);
-            evt.last_evt=READ32(base, EvtFIFOEvt);
-
-            // update any timestamp buffers
-            for(eventCode::tbufs_t::const_iterator it(evt.tbufs.begin()), end(evt.tbufs.end());
-                it!=end; ++it)
-            {
-                EVRMRMTSBuffer* tbuf = *it;
-
-                if(tbuf->timeEvt==code) {
-                    EVRMRMTSBuffer::ebuf_t& buf = tbuf->ebufs[tbuf->active];
-                    // add code to buffer
-                    if(buf.pos < buf.buf.size()) {
-                        // append raw time to buffer
-                        buf.buf[buf.pos].secPastEpoch = evt.last_sec;
-                        buf.buf[buf.pos].nsec = evt.last_evt;
-                        buf.pos++;
-
-                    } else {
-                        buf.drop = true;
-                        tbuf->dropped++;
-                    }
-                }
-
-                if(tbuf->flushEvt==code) {
-                    // flush
-                    EVRMRMTSBuffer::ebuf_t& active = tbuf->ebufs[tbuf->active];
-                    active.flushtime.secPastEpoch = evt.last_sec;
-                    active.flushtime.nsec = evt.last_evt;
-
-                    active.ok &= convertTS(&active.flushtime);
-
-                    tbuf->doFlush();
-                }
-            }
-
-            if (evt.again) {
-                // ignore extra events in buffer.
-            } else if (evt.waitingfor>0) {
-                // already queued, but received again before all
-                // callbacks finished.  Un-map event until complete
-                evt.again=true;
-                specialSetMap(code, ActionFIFOSave, false);
-                count_FIFO_sw_overrate++;
+            epicsUInt32 sec=READ32(base, EvtFIFOSec);
+            epicsUInt32 evt=READ32(base, EvtFIFOEvt);
+            nreads+=2;
+
+            if(useFIFORing) {
+                fifoEntry ent;
+                ent.code = code;
+                ent.sec = sec;
+                ent.evt = evt;
+                if(!fifo_ring.push(ent))
+                    count_fifo_ring_drop++;
             } else {
-                // needs to be queued
-                eventInvoke(evt);
+                fifoEvent(code, sec, evt, now);
             }
 
         }
 
+        if(i>0) {
+            // FIFOFull or RXErr may have been raised during the batch
+            status=READ32(base, IRQFlag);
+            nreads++;
+        }
+        count_fifo_reads+=nreads;
+
+        if(useFIFORing) {
+            dispatch_fifo_wakeup.signal();
+            guard.lock();
+        }
+
         if (status&IRQ_FIFOFull) {
             count_FIFO_overflow++;
         }
@@ -1380,13 +1753,14 @@ EVRMRM::drain_fifo()
 
         epicsInterruptUnlock(iflags);
 
-        // wait a fixed interval before checking again
+        // wait before checking again
         // Prevents this thread from starving others
         // if a high frequency event is accidentally
         // mapped into the FIFO.
-        if(mrmEvrFIFOPeriod>0.0) {
+        double holdoff = fifoHoldoffNext(i);
+        if(holdoff>0.0) {
             guard.unlock();
-            epicsThreadSleep(mrmEvrFIFOPeriod);
+            epicsThreadSleep(holdoff);
             guard.lock();
         }
     }
@@ -1395,19 +1769,399 @@ EVRMRM::drain_fifo()
 }
 
 void
-EVRMRM::sentinel_done(CALLBACK* cb)
+EVRMRM::latencyNow(epicsTimeStamp *now) const
 {
-try {
-    void *vptr;
-    callbackGetUser(vptr,cb);
-    eventCode *sent=static_cast<eventCode*>(vptr);
+    now->secPastEpoch=0;
+    now->nsec=0;
+    if(latencyEna)
+        epicsTimeGetCurrent(now);
+}
 
-    SCOPED_LOCK2(sent->owner->evrLock, guard);
+void
+EVRMRM::fifoEvent(epicsUInt32 code, epicsUInt32 sec, epicsUInt32 evtick,
+                  const epicsTimeStamp& now)
+{
+    eventCode& evt = events[code];
+
+    // cache of last time
+    {
+        epicsTimeStamp raw;
+        raw.secPastEpoch=sec;
+        raw.nsec=evtick;
+        evt.last.store(raw);
+    }
+
+    /* Host time when dispatched less the event time.  These are different
+     * clocks, so this includes any offset of the host clock from EVR time.
+     * In direct mode "dispatched" is the start of the FIFO batch.
+     */
+    if(latencyEna && now.secPastEpoch) {
+        // convert without the side effects of convertTS()
+        epicsUInt64 scale=tsTickScale();
+        if(timestampValid>=TSValidThreshold && sec!=0 && scale)
+        {
+            epicsTimeStamp ets;
+            ets.secPastEpoch=sec-POSIX_TIME_AT_EPICS_EPOCH;
+            ets.nsec=ticks2ns(evtick, scale);
+            if(ets.nsec<1000000000u)
+                evt.lat_drain.add(epicsTimeDiffInSeconds(&now, &ets));
+        }
+    }
+
+    // update any timestamp buffers
+    for(eventCode::tbufs_t::const_iterator it(evt.tbufs.begin()), end(evt.tbufs.end());
+        it!=end; ++it)
+    {
+        EVRMRMTSBuffer* tbuf = *it;
+
+        if(tbuf->timeEvt==code) {
+            tbuf->ringPush(sec, evtick);
+
+            EVRMRMTSBuffer::ebuf_t& buf = tbuf->ebufs[tbuf->active];
+            // add code to buffer
+            if(buf.pos < buf.buf.size()) {
+                // append raw time to buffer
+                buf.buf[buf.pos].secPastEpoch = sec;
+                buf.buf[buf.pos].nsec = evtick;
+                buf.pos++;
+
+            } else {
+                buf.drop = true;
+                tbuf->dropped++;
+            }
+        }
+
+        if(tbuf->flushEvt==code) {
+            // flush
+            EVRMRMTSBuffer::ebuf_t& active = tbuf->ebufs[tbuf->active];
+            active.flushtime.secPastEpoch = sec;
+            active.flushtime.nsec = evtick;
+
+            active.ok &= convertTS(&active.flushtime);
+
+            tbuf->doFlush();
+        }
+    }
+
+    if (evt.again) {
+        // ignore extra events in buffer.
+    } else if (evt.waitingfor>0) {
+        // already queued, but received again before all
+        // callbacks finished.  Un-map event until complete
+        evt.again=true;
+        specialSetMap(code, ActionFIFOSave, false);
+        count_FIFO_sw_overrate++;
+    } else {
+        // needs to be queued
+#ifdef HAVE_TS_EXTRAPOLATE
+        if(latencyEna)
+            evt.drain_mono=epicsMonotonicGet();
+#endif
+        eventInvoke(evt);
+    }
+}
+
+/* Interrupt moderation.
+ *
+ * Choose how long the FIFO thread sleeps before re-enabling
+ * the FIFO interrupts, given the number of events just taken.
+ *
+ * - Quiet (0 or 1 event) re-arms immediately for lowest latency.
+ * - A batch of at least fifoBatchTarget_ events doubles the holdoff
+ *   up to fifoHoldoffMax_, so more events are taken in each wakeup.
+ * - Smaller batches halve it again.
+ *
+ * fifoBatchTarget_==0 selects the old fixed sleep of fifoHoldoffMax_.
+ *
+ * Caller must hold evrLock
+ */
+double
+EVRMRM::fifoHoldoffNext(size_t nevents)
+{
+    if(fifoBatchTarget_==0) {
+        fifoHoldoff = fifoHoldoffMax_;
+
+    } else if(nevents<=1) {
+        fifoHoldoff = 0.0;
+
+    } else if(nevents>=fifoBatchTarget_) {
+        if(fifoHoldoff<=0.0)
+            fifoHoldoff = fifoHoldoffMax_/8.0;
+        else
+            fifoHoldoff *= 2.0;
+
+    } else {
+        fifoHoldoff /= 2.0;
+        if(fifoHoldoff < fifoHoldoffMax_/8.0)
+            fifoHoldoff = 0.0;
+    }
+
+    if(fifoHoldoff>fifoHoldoffMax_)
+        fifoHoldoff = fifoHoldoffMax_;
+    return fifoHoldoff;
+}
+
+double
+EVRMRM::FIFOHoldoff() const
+{
+    SCOPED_LOCK(evrLock);
+    return fifoHoldoff;
+}
+
+double
+EVRMRM::FIFOHoldoffMax() const
+{
+    SCOPED_LOCK(evrLock);
+    return fifoHoldoffMax_;
+}
+
+void
+EVRMRM::setFIFOHoldoffMax(double v)
+{
+    if(v<0.0 || !isfinite(v))
+        throw std::out_of_range("FIFO holdoff must be >= 0");
+    SCOPED_LOCK(evrLock);
+    fifoHoldoffMax_ = v;
+}
+
+epicsUInt32
+EVRMRM::FIFOBatchTarget() const
+{
+    SCOPED_LOCK(evrLock);
+    return fifoBatchTarget_;
+}
+
+void
+EVRMRM::setFIFOBatchTarget(epicsUInt32 v)
+{
+    if(v>512)
+        throw std::out_of_range("FIFO batch target must be <= 512");
+    SCOPED_LOCK(evrLock);
+    fifoBatchTarget_ = v;
+}
+
+void
+latencyHist::add(double sec)
+{
+    double us=sec*1e6;
+    unsigned n=0;
+    for(double edge=1.0; n<nbins-1u && us>=edge; edge*=2.0)
+        n++;
+    bins[n]++;
+}
+
+double
+latencyHist::binLow(unsigned n)
+{
+    return n==0 ? 0.0 : ldexp(1.0, int(n)-1);
+}
 
+bool
+EVRMRM::latencyEnabled() const
+{
+    SCOPED_LOCK(evrLock);
+    return latencyEna;
+}
+
+void
+EVRMRM::latencyEnable(bool v)
+{
+    SCOPED_LOCK(evrLock);
+    latencyEna=v;
+}
+
+epicsUInt32
+EVRMRM::latencyCode() const
+{
+    SCOPED_LOCK(evrLock);
+    return latencySel;
+}
+
+void
+EVRMRM::setLatencyCode(epicsUInt32 code)
+{
+    if(code>255)
+        throw std::out_of_range("Invalid event number");
+    SCOPED_LOCK(evrLock);
+    latencySel=code;
+}
+
+static
+epicsUInt32 copyHist(const latencyHist& H, epicsUInt32 *arr, epicsUInt32 count)
+{
+    if(count>latencyHist::nbins)
+        count=latencyHist::nbins;
+    std::copy(H.bins, H.bins+count, arr);
+    return count;
+}
+
+epicsUInt32
+EVRMRM::latencyDrain(epicsUInt32 *arr, epicsUInt32 count) const
+{
+    SCOPED_LOCK(evrLock);
+    return copyHist(events[latencySel].lat_drain, arr, count);
+}
+
+epicsUInt32
+EVRMRM::latencyDone(epicsUInt32 *arr, epicsUInt32 count) const
+{
+    SCOPED_LOCK(evrLock);
+    return copyHist(events[latencySel].lat_done, arr, count);
+}
+
+epicsUInt32
+EVRMRM::latencyBins(double *arr, epicsUInt32 count) const
+{
+    if(count>latencyHist::nbins)
+        count=latencyHist::nbins;
+    for(epicsUInt32 i=0; i<count; i++)
+        arr[i]=latencyHist::binLow(i);
+    return count;
+}
+
+void
+EVRMRM::latencyReset()
+{
+    SCOPED_LOCK(evrLock);
+    for(size_t i=0; i<NELEMENTS(events); i++) {
+        events[i].lat_drain.clear();
+        events[i].lat_done.clear();
+    }
+}
+
+void
+EVRMRM::latencyReport(epicsUInt32 code) const
+{
+    if(code>255)
+        throw std::out_of_range("Invalid event number");
+
+    // copy so that printing is done without the lock
+    std::vector<std::pair<epicsUInt32, std::pair<latencyHist, latencyHist> > > hists;
+    bool ena;
+    {
+        SCOPED_LOCK(evrLock);
+        ena=latencyEna;
+        for(epicsUInt32 i=code ? code : 1; i<=(code ? code : 255u); i++) {
+            const eventCode& evt=events[i];
+            bool empty=true;
+            for(unsigned n=0; empty && n<latencyHist::nbins; n++)
+                empty = evt.lat_drain.bins[n]==0 && evt.lat_done.bins[n]==0;
+            if(!empty || code)
+                hists.push_back(std::make_pair(i, std::make_pair(evt.lat_drain, evt.lat_done)));
+        }
+    }
+
+    printf("%s latency histograms (%s)\n", name().c_str(), ena ? "enabled" : "disabled");
+    for(size_t i=0; i<hists.size(); i++) {
+        const latencyHist& drain=hists[i].second.first;
+        const latencyHist& done=hists[i].second.second;
+        printf(" Event %u\n  >= us\t    drain\t     done\n", (unsigned)hists[i].first);
+        for(unsigned n=0; n<latencyHist::nbins; n++) {
+            if(drain.bins[n]==0 && done.bins[n]==0)
+                continue;
+            printf("  %7.0f\t%9u\t%9u\n", latencyHist::binLow(n),
+                   (unsigned)drain.bins[n], (unsigned)done.bins[n]);
+        }
+    }
+}
+
+void
+EVRMRM::bindWorker(const std::vector<epicsUInt8>& codes, unsigned int prio, int cpu)
+{
+    for(size_t i=0; i<codes.size(); i++) {
+        if(codes[i]==0)
+            throw std::out_of_range("Invalid event number");
+    }
+
+    std::ostringstream wname;
+    wname<<name()<<":W"<<workers.size();
+
+    mrf::auto_ptr<EVRMRMWorker> W(new EVRMRMWorker(*this, wname.str(), prio, cpu));
+
+    SCOPED_LOCK(evrLock);
+
+    for(size_t i=0; i<codes.size(); i++) {
+        if(events[codes[i]].worker)
+            throw std::runtime_error(SB()<<"Event "<<unsigned(codes[i])<<" already has a worker");
+    }
+
+    for(size_t i=0; i<codes.size(); i++)
+        events[codes[i]].worker = W.get();
+
+    workers.push_back(W.release());
+}
+
+epicsUInt32
+EVRMRM::workerDrop() const
+{
+    SCOPED_LOCK(evrLock);
+    epicsUInt32 ret = 0;
+    for(size_t w=0; w<workers.size(); w++)
+        ret += workers[w]->droppedCount();
+    return ret;
+}
+
+void
+EVRMRM::workerReport() const
+{
+    SCOPED_LOCK(evrLock);
+    for(size_t w=0; w<workers.size(); w++) {
+        const EVRMRMWorker *W = workers[w];
+        printf("\tWorker %s CPU %d processed %u dropped %u events:",
+               W->name().c_str(), W->cpu(), (unsigned)W->processedCount(),
+               (unsigned)W->droppedCount());
+        for(size_t i=1; i<NELEMENTS(events); i++) {
+            if(events[i].worker==W)
+                printf(" %u", (unsigned)i);
+        }
+        printf("\n");
+    }
+}
+
+void
+EVRMRM::dispatch_fifo()
+{
+    printf("EVR FIFO dispatch task start\n");
+
+    fifoEntry ent;
+
+    while(true) {
+        dispatch_fifo_wakeup.wait();
+
+        {
+            SCOPED_LOCK(evrLock);
+            if(dispatch_fifo_stop)
+                break;
+        }
+
+        // lock for each event so that other users of
+        // evrLock can interleave during a burst
+        while(fifo_ring.pop(ent)) {
+            epicsTimeStamp now;
+            latencyNow(&now);
+            SCOPED_LOCK(evrLock);
+            fifoEvent(ent.code, ent.sec, ent.evt, now);
+        }
+    }
+
+    printf("FIFO dispatch task exiting\n");
+}
+
+void
+EVRMRM::eventComplete(eventCode* sent)
+{
     // Is this the last callback queue?
     if (--sent->waitingfor)
         return;
 
+#ifdef HAVE_TS_EXTRAPOLATE
+    // monotonic, as generalTime may not be called with evrLock held
+    if(sent->drain_mono) {
+        sent->lat_done.add((epicsMonotonicGet()-sent->drain_mono)*1e-9);
+        sent->drain_mono=0u;
+    }
+#endif
+
     bool run=sent->again;
     sent->again=false;
 
@@ -1415,6 +2169,19 @@ try {
     if (run && sent->interested) {
         sent->owner->specialSetMap(sent->code, ActionFIFOSave, true);
     }
+}
+
+void
+EVRMRM::sentinel_done(CALLBACK* cb)
+{
+try {
+    void *vptr;
+    callbackGetUser(vptr,cb);
+    eventCode *sent=static_cast<eventCode*>(vptr);
+
+    SCOPED_LOCK2(sent->owner->evrLock, guard);
+
+    eventComplete(sent);
 } catch(std::exception& e) {
     epicsPrintf("exception in sentinel_done callback: %s\n", e.what());
 }
@@ -1440,6 +2207,7 @@ try {
             evr->timestampValid=0;
 
             evr->lastInvalidTimestamp=evr->lastValidTimestamp;
+            evr->publishTSState();
             scanIoRequest(evr->timestampValidChange);
         }
         WRITE32(evr->base, IRQFlag, IRQ_RXErr);
@@ -1533,6 +2301,10 @@ EVRMRM::seconds_tick(void *raw, epicsUInt32)
         }
     }
 
+    evr->publishTSState();
+
+    evr->sampleTSX();
+
     if(evr->timeSrcMode==External) {
         // avoid lock ordering problem with EVR lock and generalTime locks
         callbackSetCallback(&send_timestamp, &evr->timeSrc_cb);
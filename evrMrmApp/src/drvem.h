@@ -25,15 +25,22 @@
 #include <epicsTime.h>
 #include <epicsThread.h>
 #include <epicsMessageQueue.h>
+#include <epicsEvent.h>
 #include <callback.h>
 #include <epicsMutex.h>
 
+#include "mrf/spscring.h"
+#include "mrf/seqlock.h"
+#include "mrf/pollirq.h"
+#include "mrf/regshadow.h"
+
 #include "drvemInput.h"
 #include "drvemOutput.h"
 #include "drvemPrescaler.h"
 #include "drvemPulser.h"
 #include "drvemCML.h"
 #include "drvemTSBuffer.h"
+#include "drvemWorker.h"
 #include "delayModule.h"
 #include "drvemRxBuf.h"
 #include "mrmevrseq.h"
@@ -47,6 +54,26 @@
 
 class EVRMRM;
 
+/** Histogram of latencies with log2 bins (microseconds)
+ *
+ * bin 0 is < 1us (including negative)
+ * bin n is [2^(n-1), 2^n) us
+ * the last bin also counts anything longer
+ */
+struct latencyHist {
+    enum {nbins=24};
+    epicsUInt32 bins[nbins];
+
+    latencyHist() {clear();}
+    void clear() {
+        for(unsigned i=0; i<nbins; i++)
+            bins[i]=0;
+    }
+    void add(double sec);
+    //! Lower edge of bin n in microseconds
+    static double binLow(unsigned n);
+};
+
 struct eventCode {
     epicsUInt8 code; // constant
     EVRMRM* owner;
@@ -56,8 +83,9 @@ struct eventCode {
     // counter is non-zero.
     size_t interested;
 
-    epicsUInt32 last_sec;
-    epicsUInt32 last_evt;
+    // Raw (POSIX sec. and ticks) time of last occurrence.
+    // Stored by fifoEvent() with evrLock held.  Readable without.
+    mrf::SeqLocked<epicsTimeStamp> last;
 
     typedef std::set<EVRMRMTSBuffer*> tbufs_t;
     tbufs_t tbufs;
@@ -71,8 +99,20 @@ struct eventCode {
     size_t waitingfor;
     bool again;
 
-    eventCode():owner(0), interested(0), last_sec(0)
-            ,last_evt(0), waitingfor(0), again(false)
+    // When set, I/O Intr scans are run by this thread
+    // instead of the shared callback queues.
+    EVRMRMWorker *worker;
+
+    // When latency histograms are enabled.
+    // epicsMonotonicGet() when last dispatched.  0 if not recorded.
+    epicsUInt64 drain_mono;
+    latencyHist lat_drain; // host time when dispatched - event time
+    latencyHist lat_done;  // last callback done - drain_mono
+
+    eventCode():owner(0), interested(0)
+            ,waitingfor(0), again(false)
+            ,worker(0)
+            ,drain_mono(0u)
     {
         scanIoInit(&occured);
         // done - initialized in EVRMRM::EVRMRM()
@@ -138,6 +178,32 @@ public:
     virtual bool specialMapped(epicsUInt32 code, epicsUInt32 func) const OVERRIDE FINAL;
     virtual void specialSetMap(epicsUInt32 code, epicsUInt32 func,bool) OVERRIDE FINAL;
 
+    /** @name Mapping RAM
+     *
+     * The driver keeps an image of the mapping RAM in host memory,
+     * which is the only copy it reads.  Changes are written through
+     * one word at a time, except between mapDefer() and mapCommit().
+     * mapCommit() writes the whole image in one pass, into the inactive
+     * RAM followed by a switch of the active RAM (evrMrmMapBankSwitch!=0),
+     * so that outputs never see a partial configuration.
+     *
+     * Deferred from construction until the IOC is running.
+     */
+    //@{
+    enum mapBlock_t {MapInternal=0, MapTrigger=1, MapSet=2, MapReset=3};
+    //! Begin deferring mapping RAM writes.  May be nested.
+    void mapDefer();
+    //! End deferral.  The outermost call writes the whole image.
+    void mapCommit();
+    //! Set or clear bits of one event code.  Takes evrLock
+    void mapModify(epicsUInt8 evt, mapBlock_t block, epicsUInt32 mask, bool set);
+    //! Current (maybe not yet written) mapping of one event code
+    epicsUInt32 mapWord(epicsUInt8 evt, mapBlock_t block) const
+    {SCOPED_LOCK(evrLock);return mapImage[evt][block];}
+    //! Index of the mapping RAM in use
+    unsigned mapBankActive() const {SCOPED_LOCK(evrLock);return mapBank;}
+    //@}
+
     virtual double clock() const OVERRIDE FINAL
         {SCOPED_LOCK(evrLock);return eventClock;}
     virtual void clockSet(double) OVERRIDE FINAL;
@@ -180,6 +246,19 @@ public:
 
     bool convertTS(epicsTimeStamp* ts);
 
+    /** Nanoseconds per timestamp tick as 32.32 fixed point.  0 if the
+     *  timestamp clock is invalid.  Cached, so does not take evrLock
+     *  unless the cache is being updated.
+     */
+    epicsUInt64 tsTickScale() const;
+    //! ticks * tsTickScale(), saturated to 32 bits.
+    static inline epicsUInt32 ticks2ns(epicsUInt32 ticks, epicsUInt64 scale)
+    {
+        // split to avoid overflow of the 64 bit product
+        epicsUInt64 ns = ticks*(scale>>32) + ((ticks*(scale&0xffffffffu))>>32);
+        return ns>0xffffffffu ? 0xffffffffu : epicsUInt32(ns);
+    }
+
     virtual epicsUInt16 dbus() const OVERRIDE FINAL;
 
     virtual epicsUInt32 heartbeatTIMOCount() const OVERRIDE FINAL {return count_heartbeat;}
@@ -191,6 +270,51 @@ public:
     {SCOPED_LOCK(evrLock);return count_FIFO_sw_overrate;}
     virtual epicsUInt32 FIFOEvtCount() const OVERRIDE FINAL {return count_fifo_events;}
     virtual epicsUInt32 FIFOLoopCount() const OVERRIDE FINAL {return count_fifo_loops;}
+    //! Events lost because the dispatch ring was full (mrmEvrFIFORing mode)
+    epicsUInt32 FIFORingDrop() const {return count_fifo_ring_drop;}
+    //! Number of register reads made while draining the FIFO
+    epicsUInt32 FIFOReadCount() const {return count_fifo_reads;}
+    //! Calls made by irqPoller, or 0 when using the card interrupt
+    epicsUInt32 IRQPollCount() const {return irqPoller.get() ? irqPoller->pollCount() : 0u;}
+    //! Mean irqPoller loop time (sec.)
+    double IRQPollLoopTime() const {return irqPoller.get() ? irqPoller->loopTime() : 0.0;}
+
+    //! Current time requests served by extrapolation, or by a latch instead
+    epicsUInt32 TSXCount() const {SCOPED_LOCK(evrLock);return count_tsx;}
+    epicsUInt32 TSXFallbackCount() const {SCOPED_LOCK(evrLock);return count_tsx_fallback;}
+    //! Extrapolation error (ns) measured at the last seconds tick
+    double TSXError() const {SCOPED_LOCK(evrLock);return tsxError;}
+
+    //! Current sleep between FIFO drains (sec.)
+    double FIFOHoldoff() const;
+    //! Upper bound on FIFO holdoff (sec.).  Latency target
+    double FIFOHoldoffMax() const;
+    void setFIFOHoldoffMax(double);
+    //! Batch size above which holdoff is increased.  Throughput target
+    epicsUInt32 FIFOBatchTarget() const;
+    void setFIFOBatchTarget(epicsUInt32);
+
+    /* Per event code latency histograms.
+     * The waveform properties show the code selected by "Latency Code".
+     */
+    bool latencyEnabled() const;
+    void latencyEnable(bool);
+    epicsUInt32 latencyCode() const;
+    void setLatencyCode(epicsUInt32);
+    epicsUInt32 latencyDrain(epicsUInt32 *arr, epicsUInt32 count) const;
+    epicsUInt32 latencyDone(epicsUInt32 *arr, epicsUInt32 count) const;
+    epicsUInt32 latencyBins(double *arr, epicsUInt32 count) const;
+    void latencyReset();
+    //! Print histograms of code, or all codes with data if code==0
+    void latencyReport(epicsUInt32 code) const;
+
+    /** Create a dedicated thread to run the I/O Intr scans of some event codes.
+     @param cpu CPU to bind to, or -1 for any
+     */
+    void bindWorker(const std::vector<epicsUInt8>& codes, unsigned int prio, int cpu);
+    void workerReport() const;
+    //! Events not run by a worker because its queue was full
+    epicsUInt32 workerDrop() const;
 
     void enableIRQ(void);
 
@@ -218,10 +342,14 @@ public:
 #if defined(__linux__) || defined(_WIN32)
     const void *isrLinuxPvt;
 #endif
+    //! Calls isr_poll() when set up with mrfIRQPoll!=0, instead of the card interrupt
+    mrf::auto_ptr<IRQPoller> irqPoller;
 
     const Config * const conf;
     volatile unsigned char * const base;
     epicsUInt32 baselen;
+    //! Configuration registers of subunits.  See cacheRegisters()
+    mrf::RegShadow shadow;
     mrmDataBufTx buftx;
     mrmBufRx bufrx;
     mrf::auto_ptr<SFP> sfp;
@@ -233,6 +361,8 @@ private:
     volatile epicsUInt32 count_heartbeat;
     volatile epicsUInt32 count_fifo_events;
     volatile epicsUInt32 count_fifo_loops;
+    volatile epicsUInt32 count_fifo_ring_drop;
+    volatile epicsUInt32 count_fifo_reads;
 
     epicsUInt32 shadowIRQEna;
 
@@ -271,12 +401,51 @@ private:
 
     mrf::auto_ptr<EvrSeqManager> seq;
 
+    typedef std::vector<EVRMRMWorker*> workers_t;
+    workers_t workers;
+
     // run when FIFO not-full IRQ is received
     void drain_fifo();
     epicsThreadRunableMethod<EVRMRM, &EVRMRM::drain_fifo> drain_fifo_method;
     epicsThread drain_fifo_task;
     epicsMessageQueue drain_fifo_wakeup;
     static void sentinel_done(CALLBACK*);
+    // Called when the last scan queue of an event completes.  Caller must hold evrLock
+    static void eventComplete(eventCode*);
+
+    // Handle one entry taken from the FIFO.  Caller must hold evrLock
+    // now is host time, taken before evrLock when latency histograms are enabled.
+    // secPastEpoch==0 if not taken.
+    void fifoEvent(epicsUInt32 code, epicsUInt32 sec, epicsUInt32 evtick,
+                   const epicsTimeStamp& now);
+    //! Host time for fifoEvent().  Call without evrLock (cf. generalTime)
+    void latencyNow(epicsTimeStamp *now) const;
+
+    /* When mrmEvrFIFORing is set, drain_fifo() only copies FIFO
+     * entries into fifo_ring, without evrLock, and dispatch_fifo()
+     * calls fifoEvent() for each, taking evrLock one event at a time.
+     */
+    struct fifoEntry {
+        epicsUInt32 code, sec, evt;
+    };
+    const bool useFIFORing; // Set by ctor
+    mrf::SPSCRing<fifoEntry, 1024> fifo_ring;
+    void dispatch_fifo();
+    epicsThreadRunableMethod<EVRMRM, &EVRMRM::dispatch_fifo> dispatch_fifo_method;
+    mrf::auto_ptr<epicsThread> dispatch_fifo_task; // only with useFIFORing
+    epicsEvent dispatch_fifo_wakeup;
+    bool dispatch_fifo_stop; // guarded by evrLock
+
+    // FIFO interrupt moderation.  Guarded by evrLock
+    double fifoHoldoff;
+    double fifoHoldoffMax_;
+    epicsUInt32 fifoBatchTarget_;
+    double fifoHoldoffNext(size_t nevents);
+
+    // Guarded by evrLock.  latencyEna is also read without by latencyNow(),
+    // where a stale value only adds or skips one sample.
+    bool latencyEna;
+    epicsUInt32 latencySel;
 
     epicsUInt32 count_FIFO_sw_overrate;
 
@@ -305,12 +474,36 @@ private:
     TSSource shadowSourceTS;
     epicsUInt32 shadowCounterPS;
     double eventClock; //!< Stored in Hz
+    // clockTS() cached as ns per tick, 32.32 fixed point.
+    // Updated with evrLock held whenever an input of clockTS() changes.
+    mrf::SeqLocked<epicsUInt64> tsScale;
+    void updateTSScale();
+
+    void cacheRegisters();
 
     epicsUInt32 timestampValid;
     epicsUInt32 lastInvalidTimestamp;
     epicsUInt32 lastValidTimestamp;
+    // Copy of the three above for lock-free readers.
+    // Updated by publishTSState() with evrLock held after any of them changes.
+    struct TSState {
+        epicsUInt32 valid, lastInvalid, lastValid;
+    };
+    mrf::SeqLocked<TSState> tsState;
+    void publishTSState();
     static void seconds_tick(void*, epicsUInt32);
 
+    // Extrapolation of the current time from the last seconds tick.
+    // Guarded by evrLock
+    bool tsxValid;
+    epicsUInt64 tsxMono; //!< monotonic ns when tsxStamp was latched
+    epicsTimeStamp tsxStamp;
+    double tsxError; //!< ns.  latched minus extrapolated, at the last tick
+    epicsUInt32 count_tsx, count_tsx_fallback;
+    void latchTS(epicsTimeStamp *ts);
+    void sampleTSX();
+    bool extrapolateTS(epicsTimeStamp *ts);
+
     // bit map of which event #'s are mapped
     // used as a safty check to avoid overloaded mappings
     epicsUInt32 _mapped[256];
@@ -319,7 +512,14 @@ private:
     void _unmap(epicsUInt8 evt, epicsUInt8 func) { _mapped[evt] &= ~( 1<<(func) );}
     bool _ismap(epicsUInt8 evt, epicsUInt8 func) const { return (_mapped[evt] & 1<<(func)) != 0; }
 
+    // Guarded by evrLock
+    epicsUInt32 mapImage[256][4]; // indexed by mapBlock_t
+    unsigned mapBank;
+    unsigned mapDeferCnt;
+    void mapWrite(unsigned bank);
+
     friend struct EVRMRMTSBuffer;
+    friend class EVRMRMWorker;
 }; // class EVRMRM
 
 #endif // EVRMRML_H_INC
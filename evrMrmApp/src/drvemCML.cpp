@@ -94,21 +94,22 @@ MRMCML::setMode(cmlMode m)
     shadowEnable &= ~OutputCMLEna_ena; // disable while syncing
     shadowEnable &= ~OutputCMLEna_mode_mask;
     shadowEnable |= mask;
-    WRITE32(base, OutputCMLEna(N), shadowEnable);
 
+    mrf::RegBatch batch(owner.shadow);
+    BATCH_WRITE32(batch, OutputCMLEna(N), shadowEnable);
 
     switch(m) {
     case cmlModeOrig:
-        WRITE32(base, OutputCMLPatLength(N), 0);
-        syncPattern(patternFall);
-        syncPattern(patternHigh);
-        syncPattern(patternLow);
-        syncPattern(patternRise);
+        BATCH_WRITE32(batch, OutputCMLPatLength(N), 0);
+        syncPattern(patternFall, batch);
+        syncPattern(patternHigh, batch);
+        syncPattern(patternLow, batch);
+        syncPattern(patternRise, batch);
         break;
 
     case cmlModePattern:
-        WRITE32(base, OutputCMLPatLength(N), shadowWaveformlength-1);
-        syncPattern(patternWaveform);
+        BATCH_WRITE32(batch, OutputCMLPatLength(N), shadowWaveformlength-1);
+        syncPattern(patternWaveform, batch);
         break;
 
     default:
@@ -117,7 +118,8 @@ MRMCML::setMode(cmlMode m)
 
     if(wasenabled)
         shadowEnable |= OutputCMLEna_ena; // enable after syncing
-    WRITE32(base, OutputCMLEna(N), shadowEnable);
+    BATCH_WRITE32(batch, OutputCMLEna(N), shadowEnable);
+    batch.flush();
 }
 
 bool
@@ -175,7 +177,7 @@ MRMCML::fineDelay() const
     // and not related to the clock frequency.
     // So just scale it to [0, 1) and use ESLO for the
     // actual calibration
-    return READ32(base, GTXDelay(N))/1024.0;
+    return SHADOW_READ32(owner.shadow, GTXDelay(N))/1024.0;
 }
 
 void
@@ -185,7 +187,7 @@ MRMCML::setFineDelay(double v)
         printf("Delay will be set to 1024 instead of %f\n", v);
         v=1024.0;
     }
-    WRITE32(base, GTXDelay(N), roundToUInt(v*1024.0));
+    SHADOW_WRITE32(owner.shadow, GTXDelay(N), roundToUInt(v*1024.0));
 }
 
 void
@@ -207,7 +209,7 @@ MRMCML::polarityInvert() const
 epicsUInt32
 MRMCML::countHigh() const
 {
-    epicsUInt32 val = READ32(base, OutputCMLCount(N));
+    epicsUInt32 val = SHADOW_READ32(owner.shadow, OutputCMLCount(N));
     val >>= OutputCMLCount_high_shft;
     return val & OutputCMLCount_mask;
 }
@@ -215,7 +217,7 @@ MRMCML::countHigh() const
 epicsUInt32
 MRMCML::countLow () const
 {
-    epicsUInt32 val = READ32(base, OutputCMLCount(N));
+    epicsUInt32 val = SHADOW_READ32(owner.shadow, OutputCMLCount(N));
     val >>= OutputCMLCount_low_shft;
     return val & OutputCMLCount_mask;
 }
@@ -233,10 +235,10 @@ MRMCML::setCountHigh(epicsUInt32 v)
 {
     v = std::max(kind==typeTG300?40u:20u, std::min(v, 65535u));
 
-    epicsUInt32 val = READ32(base, OutputCMLCount(N));
+    epicsUInt32 val = SHADOW_READ32(owner.shadow, OutputCMLCount(N));
     val &= ~(OutputCMLCount_mask << OutputCMLCount_high_shft);
     val |= v << OutputCMLCount_high_shft;
-    WRITE32(base, OutputCMLCount(N), val);
+    SHADOW_WRITE32(owner.shadow, OutputCMLCount(N), val);
 }
 
 void
@@ -244,10 +246,10 @@ MRMCML::setCountLow (epicsUInt32 v)
 {
     v = std::max(kind==typeTG300?40u:20u, std::min(v, 65535u));
 
-    epicsUInt32 val = READ32(base, OutputCMLCount(N));
+    epicsUInt32 val = SHADOW_READ32(owner.shadow, OutputCMLCount(N));
     val &= ~(OutputCMLCount_mask << OutputCMLCount_low_shft);
     val |= v << OutputCMLCount_low_shft;
-    WRITE32(base, OutputCMLCount(N), val);
+    SHADOW_WRITE32(owner.shadow, OutputCMLCount(N), val);
 }
 
 void
@@ -422,36 +424,40 @@ MRMCML::setPattern(pattern p, const unsigned char *buf, epicsUInt32 blen)
     if(p==patternWaveform)
         shadowWaveformlength = blen/mult;
 
+    mrf::RegBatch batch(owner.shadow);
+
     // temporarly disable when changing multi dword patterns
     // to prevent output of incomplete patterns
     bool active=enabled();
     if(active)
-        enable(false);
+        BATCH_WRITE32(batch, OutputCMLEna(N), shadowEnable&~OutputCMLEna_ena);
 
     if(mode()==cmlModePattern)
-        WRITE32(base, OutputCMLPatLength(N), shadowWaveformlength-1);
+        BATCH_WRITE32(batch, OutputCMLPatLength(N), shadowWaveformlength-1);
 
-    syncPattern(p);
+    syncPattern(p, batch);
 
     if(active)
-        enable(true);
+        BATCH_WRITE32(batch, OutputCMLEna(N), shadowEnable);
+
+    batch.flush();
 }
 
 void
-MRMCML::syncPattern(pattern p)
+MRMCML::syncPattern(pattern p, mrf::RegBatch& batch)
 {
     if(mult==20 && p!=patternWaveform) {
         // for 20 bit patterns modifying the 4x pattern
         // can be done without effecting the waveform pattern
         switch(p) {
         case patternHigh:
-            WRITE32(base, OutputCMLHigh(N), shadowPattern[patternHigh][0]); return;
+            BATCH_WRITE32(batch, OutputCMLHigh(N), shadowPattern[patternHigh][0]); return;
         case patternFall:
-            WRITE32(base, OutputCMLFall(N), shadowPattern[patternFall][0]); return;
+            BATCH_WRITE32(batch, OutputCMLFall(N), shadowPattern[patternFall][0]); return;
         case patternLow:
-            WRITE32(base, OutputCMLLow(N),  shadowPattern[patternLow][0]);  return;
+            BATCH_WRITE32(batch, OutputCMLLow(N),  shadowPattern[patternLow][0]);  return;
         case patternRise:
-            WRITE32(base, OutputCMLRise(N), shadowPattern[patternRise][0]); return;
+            BATCH_WRITE32(batch, OutputCMLRise(N), shadowPattern[patternRise][0]); return;
         default:
             throw std::logic_error("syncPattern: invalid state 20");
         }
@@ -466,23 +472,23 @@ MRMCML::syncPattern(pattern p)
 
         switch(p) {
         case patternLow:
-            WRITE32(base, OutputCMLPat(N, 0), shadowPattern[patternLow][0]);
-            WRITE32(base, OutputCMLPat(N, 1), shadowPattern[patternLow][1]);
+            BATCH_WRITE32(batch, OutputCMLPat(N, 0), shadowPattern[patternLow][0]);
+            BATCH_WRITE32(batch, OutputCMLPat(N, 1), shadowPattern[patternLow][1]);
             break;
 
         case patternRise:
-            WRITE32(base, OutputCMLPat(N, 2), shadowPattern[patternRise][0]);
-            WRITE32(base, OutputCMLPat(N, 3), shadowPattern[patternRise][1]);
+            BATCH_WRITE32(batch, OutputCMLPat(N, 2), shadowPattern[patternRise][0]);
+            BATCH_WRITE32(batch, OutputCMLPat(N, 3), shadowPattern[patternRise][1]);
             break;
 
         case patternFall:
-            WRITE32(base, OutputCMLPat(N, 4), shadowPattern[patternFall][0]);
-            WRITE32(base, OutputCMLPat(N, 5), shadowPattern[patternFall][1]);
+            BATCH_WRITE32(batch, OutputCMLPat(N, 4), shadowPattern[patternFall][0]);
+            BATCH_WRITE32(batch, OutputCMLPat(N, 5), shadowPattern[patternFall][1]);
             break;
 
         case patternHigh:
-            WRITE32(base, OutputCMLPat(N, 6), shadowPattern[patternHigh][0]);
-            WRITE32(base, OutputCMLPat(N, 7), shadowPattern[patternHigh][1]);
+            BATCH_WRITE32(batch, OutputCMLPat(N, 6), shadowPattern[patternHigh][0]);
+            BATCH_WRITE32(batch, OutputCMLPat(N, 7), shadowPattern[patternHigh][1]);
             break;
 
         case patternWaveform:
@@ -494,7 +500,7 @@ MRMCML::syncPattern(pattern p)
         switch(p) {
         case patternWaveform:
             for(size_t i=0; i<shadowWaveformlength*wordlen; i++)
-                WRITE32(base, OutputCMLPat(N, i), shadowPattern[patternWaveform][i]);
+                BATCH_WRITE32(batch, OutputCMLPat(N, i), shadowPattern[patternWaveform][i]);
             break;
         default:
             break; // not safe to sync
@@ -14,6 +14,7 @@
 #include "evr/cml.h"
 
 #include "configurationInfo.h"
+#include "mrf/regshadow.h"
 
 class EVRMRM;
 
@@ -86,7 +87,8 @@ private:
     epicsUInt32 *shadowPattern[5]; // 5 is wavefrom + 4x pattern
     epicsUInt32  shadowWaveformlength;
 
-    void syncPattern(pattern);
+    // queue writes of a pattern
+    void syncPattern(pattern, mrf::RegBatch&);
 
     outkind kind;
 };
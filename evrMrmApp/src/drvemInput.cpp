@@ -17,9 +17,9 @@
 #include "evrRegMap.h"
 #include "drvemInput.h"
 
-MRMInput::MRMInput(const std::string& n, volatile unsigned char *b, size_t i)
+MRMInput::MRMInput(const std::string& n, mrf::RegShadow& s, size_t i)
   :Input(n)
-  ,base(b)
+  ,shadow(s)
   ,idx(i)
 {
 }
@@ -29,17 +29,17 @@ MRMInput::dbusSet(epicsUInt16 v)
 {
     epicsUInt32 val;
 
-    val = READ32(base, InputMapFP(idx) );
+    val = SHADOW_READ32(shadow, InputMapFP(idx));
     val &= ~InputMapFP_dbus_mask;
     val |= v << InputMapFP_dbus_shft;
-    WRITE32(base, InputMapFP(idx), val);
+    SHADOW_WRITE32(shadow, InputMapFP(idx), val);
 }
 
 epicsUInt16
 MRMInput::dbus() const
 {
     epicsUInt32 val;
-    val = READ32(base, InputMapFP(idx) );
+    val = SHADOW_READ32(shadow, InputMapFP(idx));
     val &= InputMapFP_dbus_mask;
     val >>= InputMapFP_dbus_shft;
     return val;
@@ -49,30 +49,30 @@ void
 MRMInput::levelHighSet(bool v)
 {
     if(v)
-        BITCLR(NAT,32, base, InputMapFP(idx), InputMapFP_lvl);
+        SHADOW_BITCLR32(shadow, InputMapFP(idx), InputMapFP_lvl);
     else
-        BITSET(NAT,32, base, InputMapFP(idx), InputMapFP_lvl);
+        SHADOW_BITSET32(shadow, InputMapFP(idx), InputMapFP_lvl);
 }
 
 bool
 MRMInput::levelHigh() const
 {
-    return !(READ32(base,InputMapFP(idx)) & InputMapFP_lvl);
+    return !(SHADOW_READ32(shadow, InputMapFP(idx)) & InputMapFP_lvl);
 }
 
 void
 MRMInput::edgeRiseSet(bool v)
 {
     if(v)
-        BITCLR(NAT,32, base, InputMapFP(idx), InputMapFP_edge);
+        SHADOW_BITCLR32(shadow, InputMapFP(idx), InputMapFP_edge);
     else
-        BITSET(NAT,32, base, InputMapFP(idx), InputMapFP_edge);
+        SHADOW_BITSET32(shadow, InputMapFP(idx), InputMapFP_edge);
 }
 
 bool
 MRMInput::edgeRise() const
 {
-    return !(READ32(base,InputMapFP(idx)) & InputMapFP_edge);
+    return !(SHADOW_READ32(shadow, InputMapFP(idx)) & InputMapFP_edge);
 }
 
 void
@@ -81,18 +81,18 @@ MRMInput::extModeSet(TrigMode m)
     switch(m){
     case TrigNone:
         // Disable both level and edge
-        BITCLR(NAT,32, base, InputMapFP(idx), InputMapFP_eedg);
-        BITCLR(NAT,32, base, InputMapFP(idx), InputMapFP_elvl);
+        SHADOW_BITCLR32(shadow, InputMapFP(idx), InputMapFP_eedg);
+        SHADOW_BITCLR32(shadow, InputMapFP(idx), InputMapFP_elvl);
         break;
     case TrigLevel:
         // disable edge, enable level
-        BITCLR(NAT,32, base, InputMapFP(idx), InputMapFP_eedg);
-        BITSET(NAT,32, base, InputMapFP(idx), InputMapFP_elvl);
+        SHADOW_BITCLR32(shadow, InputMapFP(idx), InputMapFP_eedg);
+        SHADOW_BITSET32(shadow, InputMapFP(idx), InputMapFP_elvl);
         break;
     case TrigEdge:
         // disable level, enable edge
-        BITSET(NAT,32, base, InputMapFP(idx), InputMapFP_eedg);
-        BITCLR(NAT,32, base, InputMapFP(idx), InputMapFP_elvl);
+        SHADOW_BITSET32(shadow, InputMapFP(idx), InputMapFP_eedg);
+        SHADOW_BITCLR32(shadow, InputMapFP(idx), InputMapFP_elvl);
         break;
     }
 }
@@ -100,7 +100,7 @@ MRMInput::extModeSet(TrigMode m)
 TrigMode
 MRMInput::extMode() const
 {
-    epicsUInt32 v=READ32(base, InputMapFP(idx));
+    epicsUInt32 v=SHADOW_READ32(shadow, InputMapFP(idx));
 
     bool e = (v&InputMapFP_eedg) != 0;
     bool l = (v&InputMapFP_elvl) != 0;
@@ -125,10 +125,10 @@ MRMInput::extEvtSet(epicsUInt32 e)
 
     epicsUInt32 val;
 
-    val = READ32(base, InputMapFP(idx) );
+    val = SHADOW_READ32(shadow, InputMapFP(idx));
     val &= ~InputMapFP_ext_mask;
     val |= e << InputMapFP_ext_shft;
-    WRITE32(base, InputMapFP(idx), val);
+    SHADOW_WRITE32(shadow, InputMapFP(idx), val);
 
     epicsInterruptUnlock(key);
 }
@@ -137,7 +137,7 @@ epicsUInt32
 MRMInput::extEvt() const
 {
     epicsUInt32 val;
-    val = READ32(base, InputMapFP(idx) );
+    val = SHADOW_READ32(shadow, InputMapFP(idx));
     val &= InputMapFP_ext_mask;
     val >>= InputMapFP_ext_shft;
     return val;
@@ -149,18 +149,18 @@ MRMInput::backModeSet(TrigMode m)
     switch(m){
     case TrigNone:
         // Disable both level and edge
-        BITCLR(NAT,32, base, InputMapFP(idx), InputMapFP_bedg);
-        BITCLR(NAT,32, base, InputMapFP(idx), InputMapFP_blvl);
+        SHADOW_BITCLR32(shadow, InputMapFP(idx), InputMapFP_bedg);
+        SHADOW_BITCLR32(shadow, InputMapFP(idx), InputMapFP_blvl);
         break;
     case TrigLevel:
         // disable edge, enable level
-        BITCLR(NAT,32, base, InputMapFP(idx), InputMapFP_bedg);
-        BITSET(NAT,32, base, InputMapFP(idx), InputMapFP_blvl);
+        SHADOW_BITCLR32(shadow, InputMapFP(idx), InputMapFP_bedg);
+        SHADOW_BITSET32(shadow, InputMapFP(idx), InputMapFP_blvl);
         break;
     case TrigEdge:
         // disable level, enable edge
-        BITSET(NAT,32, base, InputMapFP(idx), InputMapFP_bedg);
-        BITCLR(NAT,32, base, InputMapFP(idx), InputMapFP_blvl);
+        SHADOW_BITSET32(shadow, InputMapFP(idx), InputMapFP_bedg);
+        SHADOW_BITCLR32(shadow, InputMapFP(idx), InputMapFP_blvl);
         break;
     }
 }
@@ -168,7 +168,7 @@ MRMInput::backModeSet(TrigMode m)
 TrigMode
 MRMInput::backMode() const
 {
-    epicsUInt32 v=READ32(base, InputMapFP(idx));
+    epicsUInt32 v=SHADOW_READ32(shadow, InputMapFP(idx));
 
     bool e = (v&InputMapFP_bedg) != 0;
     bool l = (v&InputMapFP_blvl) != 0;
@@ -193,10 +193,10 @@ MRMInput::backEvtSet(epicsUInt32 e)
 
     epicsUInt32 val;
 
-    val = READ32(base, InputMapFP(idx) );
+    val = SHADOW_READ32(shadow, InputMapFP(idx));
     val &= ~InputMapFP_back_mask;
     val |= e << InputMapFP_back_shft;
-    WRITE32(base, InputMapFP(idx), val);
+    SHADOW_WRITE32(shadow, InputMapFP(idx), val);
 
     epicsInterruptUnlock(key);
 }
@@ -205,7 +205,7 @@ epicsUInt32
 MRMInput::backEvt() const
 {
     epicsUInt32 val;
-    val = READ32(base, InputMapFP(idx) );
+    val = SHADOW_READ32(shadow, InputMapFP(idx));
     val &= InputMapFP_back_mask;
     val >>= InputMapFP_back_shft;
     return val;
@@ -13,6 +13,7 @@
 
 #include <cstdlib>
 #include "evr/input.h"
+#include "mrf/regshadow.h"
 
 /**
  * Controls only the single output mapping register
@@ -24,7 +25,7 @@
 class MRMInput : public Input
 {
 public:
-    MRMInput(const std::string& n, volatile unsigned char *, size_t);
+    MRMInput(const std::string& n, mrf::RegShadow&, size_t);
     virtual ~MRMInput(){};
 
     /* no locking needed */
@@ -53,7 +54,7 @@ public:
     virtual epicsUInt32 backEvt() const OVERRIDE FINAL;
 
 private:
-    volatile unsigned char * const base;
+    mrf::RegShadow& shadow;
     const size_t idx;
 };
 
@@ -117,6 +117,57 @@ static void mrmEvrLoopbackCallFunc(const iocshArgBuf *args)
     mrmEvrLoopback(args[0].sval,args[1].ival,args[2].ival);
 }
 
+static const iocshArg mrmEvrLatencyReportArg0 = { "name",iocshArgString};
+static const iocshArg mrmEvrLatencyReportArg1 = { "Event code (0 - all)",iocshArgInt};
+static const iocshArg * const mrmEvrLatencyReportArgs[2] =
+    {&mrmEvrLatencyReportArg0,&mrmEvrLatencyReportArg1};
+static const iocshFuncDef mrmEvrLatencyReportFuncDef =
+    {"mrmEvrLatencyReport",2,mrmEvrLatencyReportArgs};
+
+static void mrmEvrLatencyReportCallFunc(const iocshArgBuf *args)
+{
+    mrmEvrLatencyReport(args[0].sval,args[1].ival);
+}
+
+static const iocshArg mrmEvrEventWorkerArg0 = { "name",iocshArgString};
+static const iocshArg mrmEvrEventWorkerArg1 = { "Event list",iocshArgString};
+static const iocshArg mrmEvrEventWorkerArg2 = { "Thread priority 0-99",iocshArgInt};
+static const iocshArg mrmEvrEventWorkerArg3 = { "CPU (-1 - any)",iocshArgInt};
+static const iocshArg * const mrmEvrEventWorkerArgs[4] =
+    {&mrmEvrEventWorkerArg0,&mrmEvrEventWorkerArg1,&mrmEvrEventWorkerArg2,&mrmEvrEventWorkerArg3};
+static const iocshFuncDef mrmEvrEventWorkerFuncDef =
+    {"mrmEvrEventWorker",4,mrmEvrEventWorkerArgs};
+
+static void mrmEvrEventWorkerCallFunc(const iocshArgBuf *args)
+{
+    mrmEvrEventWorker(args[0].sval,args[1].sval,args[2].ival,args[3].ival);
+}
+
+static const iocshArg mrmEvrMapDeferArg0 = { "name",iocshArgString};
+static const iocshArg mrmEvrMapDeferArg1 = { "1 - defer, 0 - commit",iocshArgInt};
+static const iocshArg * const mrmEvrMapDeferArgs[2] =
+    {&mrmEvrMapDeferArg0,&mrmEvrMapDeferArg1};
+static const iocshFuncDef mrmEvrMapDeferFuncDef =
+    {"mrmEvrMapDefer",2,mrmEvrMapDeferArgs};
+
+static void mrmEvrMapDeferCallFunc(const iocshArgBuf *args)
+{
+    mrmEvrMapDefer(args[0].sval,args[1].ival);
+}
+
+static const iocshArg mrmEvrSetupSimArg0 = { "name",iocshArgString};
+static const iocshArg mrmEvrSetupSimArg1 = { "Events code@Hz,...",iocshArgString};
+static const iocshArg mrmEvrSetupSimArg2 = { "Period (s)",iocshArgDouble};
+static const iocshArg * const mrmEvrSetupSimArgs[3] =
+    {&mrmEvrSetupSimArg0,&mrmEvrSetupSimArg1,&mrmEvrSetupSimArg2};
+static const iocshFuncDef mrmEvrSetupSimFuncDef =
+    {"mrmEvrSetupSim",3,mrmEvrSetupSimArgs};
+
+static void mrmEvrSetupSimCallFunc(const iocshArgBuf *args)
+{
+    mrmEvrSetupSim(args[0].sval,args[1].sval,args[2].dval);
+}
+
 static
 void mrmsetupreg()
 {
@@ -126,6 +177,10 @@ void mrmsetupreg()
     iocshRegister(&mrmEvrDumpMapFuncDef,mrmEvrDumpMapCallFunc);
     iocshRegister(&mrmEvrForwardFuncDef,mrmEvrForwardCallFunc);
     iocshRegister(&mrmEvrLoopbackFuncDef,mrmEvrLoopbackCallFunc);
+    iocshRegister(&mrmEvrLatencyReportFuncDef,mrmEvrLatencyReportCallFunc);
+    iocshRegister(&mrmEvrEventWorkerFuncDef,mrmEvrEventWorkerCallFunc);
+    iocshRegister(&mrmEvrMapDeferFuncDef,mrmEvrMapDeferCallFunc);
+    iocshRegister(&mrmEvrSetupSimFuncDef,mrmEvrSetupSimCallFunc);
 }
 
 
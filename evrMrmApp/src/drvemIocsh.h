@@ -37,6 +37,8 @@ void epicsShareFunc
 mrmEvrSetupPCI(const char* id, const char* pcispec);
 void epicsShareFunc
 mrmEvrSetupVME(const char* id,int slot,int base,int level, int vector);
+void epicsShareFunc
+mrmEvrSetupSim(const char* id, const char* events, double period);
 
 void epicsShareFunc
 mrmEvrDumpMap(const char* id,int evt,int ram);
@@ -44,6 +46,12 @@ void epicsShareFunc
 mrmEvrForward(const char* id, const char* events_iocsh);
 void epicsShareFunc
 mrmEvrLoopback(const char* id, int rxLoopback, int txLoopback);
+void epicsShareFunc
+mrmEvrLatencyReport(const char* id, int evt);
+void epicsShareFunc
+mrmEvrEventWorker(const char* id, const char* events, int prio, int cpu);
+void epicsShareFunc
+mrmEvrMapDefer(const char* id, int defer);
 
 void epicsShareFunc
 mrmEvrInithooks(initHookState state);
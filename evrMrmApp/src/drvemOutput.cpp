@@ -105,13 +105,13 @@ MRMOutput::sourceInternal() const
     case OutputInt:
         return  READ32(owner->base, IRQPulseMap) & 0xffff;
     case OutputFP:
-        val = READ32(owner->base, OutputMapFP(N)); break;
+        val = SHADOW_READ32(owner->shadow, OutputMapFP(N)); break;
     case OutputFPUniv:
-        val = READ32(owner->base, OutputMapFPUniv(N)); break;
+        val = SHADOW_READ32(owner->shadow, OutputMapFPUniv(N)); break;
     case OutputRB:
-        val = READ32(owner->base, OutputMapRB(N)); break;
+        val = SHADOW_READ32(owner->shadow, OutputMapRB(N)); break;
     case OutputBackplane:
-        val = READ32(owner->base, OutputMapBackplane(N)); break;
+        val = SHADOW_READ32(owner->shadow, OutputMapBackplane(N)); break;
     }
     val &= Output_mask(N);
     val >>= Output_shift(N);
@@ -130,13 +130,13 @@ MRMOutput::setSourceInternal()
     case OutputInt:
         WRITE32(owner->base, IRQPulseMap, regval); return;
     case OutputFP:
-        val = READ32(owner->base, OutputMapFP(N)); break;
+        val = SHADOW_READ32(owner->shadow, OutputMapFP(N)); break;
     case OutputFPUniv:
-        val = READ32(owner->base, OutputMapFPUniv(N)); break;
+        val = SHADOW_READ32(owner->shadow, OutputMapFPUniv(N)); break;
     case OutputRB:
-        val = READ32(owner->base, OutputMapRB(N)); break;
+        val = SHADOW_READ32(owner->shadow, OutputMapRB(N)); break;
     case OutputBackplane:
-        val = READ32(owner->base, OutputMapBackplane(N)); break;
+        val = SHADOW_READ32(owner->shadow, OutputMapBackplane(N)); break;
     }
 
     val &= ~Output_mask(N);
@@ -146,13 +146,13 @@ MRMOutput::setSourceInternal()
     case OutputInt:
         break; // will not get here
     case OutputFP:
-        WRITE32(owner->base, OutputMapFP(N), val); break;
+        SHADOW_WRITE32(owner->shadow, OutputMapFP(N), val); break;
     case OutputFPUniv:
-        WRITE32(owner->base, OutputMapFPUniv(N), val); break;
+        SHADOW_WRITE32(owner->shadow, OutputMapFPUniv(N), val); break;
     case OutputRB:
-        WRITE32(owner->base, OutputMapRB(N), val); break;
+        SHADOW_WRITE32(owner->shadow, OutputMapRB(N), val); break;
     case OutputBackplane:
-        WRITE32(owner->base, OutputMapBackplane(N), val); break;
+        SHADOW_WRITE32(owner->shadow, OutputMapBackplane(N), val); break;
     }
 }
 
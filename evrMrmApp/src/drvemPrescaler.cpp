@@ -20,9 +20,10 @@
 #include <epicsExport.h>
 #include "drvemPrescaler.h"
 
-MRMPreScaler::MRMPreScaler(const std::string& n, EVR& o,volatile unsigned char* b)
+MRMPreScaler::MRMPreScaler(const std::string& n, EVR& o, mrf::RegShadow& s, epicsUInt32 offset)
     :base_t(n,o)
-    ,base(b)
+    ,shadow(s)
+    ,offset(offset)
 {}
 
 MRMPreScaler::~MRMPreScaler() {}
@@ -30,25 +31,25 @@ MRMPreScaler::~MRMPreScaler() {}
 epicsUInt32
 MRMPreScaler::prescaler() const
 {
-    return nat_ioread32(base);
+    return shadow.read32(offset);
 }
 
 void
 MRMPreScaler::setPrescaler(epicsUInt32 v)
 {
-    nat_iowrite32(base, v);
+    shadow.write32(offset, v);
 }
 
 epicsUInt32
 MRMPreScaler::prescalerPhasOffs() const
 {
-    return nat_ioread32(base + ScalerPhasOffs_offset);
+    return shadow.read32(offset + ScalerPhasOffs_offset);
 }
 
 void
 MRMPreScaler::setPrescalerPhasOffs(epicsUInt32 v)
 {
-    nat_iowrite32(base + ScalerPhasOffs_offset, v);
+    shadow.write32(offset + ScalerPhasOffs_offset, v);
 }
 
 OBJECT_BEGIN2(MRMPreScaler, PreScaler)
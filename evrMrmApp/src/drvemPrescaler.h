@@ -12,14 +12,16 @@
 #define MRMEVRPRESCALER_H_INC
 
 #include <evr/prescaler.h>
+#include "mrf/regshadow.h"
 
 class epicsShareClass MRMPreScaler : public mrf::ObjectInst<MRMPreScaler,PreScaler>
 {
     typedef mrf::ObjectInst<MRMPreScaler,PreScaler> base_t;
-    volatile unsigned char* base;
+    mrf::RegShadow& shadow;
+    const epicsUInt32 offset;
 
 public:
-    MRMPreScaler(const std::string& n, EVR& o,volatile unsigned char* b);
+    MRMPreScaler(const std::string& n, EVR& o, mrf::RegShadow& s, epicsUInt32 offset);
     virtual ~MRMPreScaler();
 
     /* no locking needed */
@@ -42,24 +42,24 @@ void MRMPulser::unlock() const{owner.unlock();};
 bool
 MRMPulser::enabled() const
 {
-    return READ32(owner.base, PulserCtrl(id)) & PulserCtrl_ena;
+    return SHADOW_READ32(owner.shadow, PulserCtrl(id)) & PulserCtrl_ena;
 }
 
 void
 MRMPulser::enable(bool s)
 {
     if(s)
-        BITSET(NAT,32,owner.base, PulserCtrl(id),
+        SHADOW_BITSET32(owner.shadow, PulserCtrl(id),
              PulserCtrl_ena|PulserCtrl_mtrg|PulserCtrl_mset|PulserCtrl_mrst);
     else
-        BITCLR(NAT,32,owner.base, PulserCtrl(id),
+        SHADOW_BITCLR32(owner.shadow, PulserCtrl(id),
              PulserCtrl_ena|PulserCtrl_mtrg|PulserCtrl_mset|PulserCtrl_mrst);
 }
 
 void
 MRMPulser::setDelayRaw(epicsUInt32 v)
 {
-    WRITE32(owner.base, PulserDely(id), v);
+    SHADOW_WRITE32(owner.shadow, PulserDely(id), v);
 }
 
 void
@@ -77,7 +77,7 @@ MRMPulser::setDelay(double v)
 epicsUInt32
 MRMPulser::delayRaw() const
 {
-    return READ32(owner.base,PulserDely(id));
+    return SHADOW_READ32(owner.shadow, PulserDely(id));
 }
 
 double
@@ -94,7 +94,9 @@ MRMPulser::delay() const
 void
 MRMPulser::setWidthRaw(epicsUInt32 v)
 {
-    WRITE32(owner.base, PulserWdth(id), v);
+    SHADOW_WRITE32(owner.shadow, PulserWdth(id), v);
+    // some pulsers have fewer than 32 bits of width.  Keep what the card accepted
+    SHADOW_RELOAD32(owner.shadow, PulserWdth(id));
 }
 
 void
@@ -112,7 +114,7 @@ MRMPulser::setWidth(double v)
 epicsUInt32
 MRMPulser::widthRaw() const
 {
-    return READ32(owner.base,PulserWdth(id));
+    return SHADOW_READ32(owner.shadow, PulserWdth(id));
 }
 
 double
@@ -129,47 +131,49 @@ MRMPulser::width() const
 epicsUInt32
 MRMPulser::prescaler() const
 {
-    return READ32(owner.base,PulserScal(id));
+    return SHADOW_READ32(owner.shadow, PulserScal(id));
 }
 
 void
 MRMPulser::setPrescaler(epicsUInt32 v)
 {
-    WRITE32(owner.base, PulserScal(id), v);
+    SHADOW_WRITE32(owner.shadow, PulserScal(id), v);
+    // not all pulsers have a prescaler.  Keep what the card accepted
+    SHADOW_RELOAD32(owner.shadow, PulserScal(id));
 }
 
 bool
 MRMPulser::polarityInvert() const
 {
-    return (READ32(owner.base, PulserCtrl(id)) & PulserCtrl_pol) != 0;
+    return (SHADOW_READ32(owner.shadow, PulserCtrl(id)) & PulserCtrl_pol) != 0;
 }
 
 void
 MRMPulser::setPolarityInvert(bool s)
 {
     if(s)
-        BITSET(NAT,32,owner.base, PulserCtrl(id), PulserCtrl_pol);
+        SHADOW_BITSET32(owner.shadow, PulserCtrl(id), PulserCtrl_pol);
     else
-        BITCLR(NAT,32,owner.base, PulserCtrl(id), PulserCtrl_pol);
+        SHADOW_BITCLR32(owner.shadow, PulserCtrl(id), PulserCtrl_pol);
 }
 
 epicsUInt32 MRMPulser::enables() const
 {
-    return (READ32(owner.base, PulserCtrl(id)) & PulserCtrl_enables)>>PulserCtrl_enables_shift;
+    return (SHADOW_READ32(owner.shadow, PulserCtrl(id)) & PulserCtrl_enables)>>PulserCtrl_enables_shift;
 }
 
 void MRMPulser::setEnables(epicsUInt32 inps)
 {
-    epicsUInt32 reg = READ32(owner.base, PulserCtrl(id));
+    epicsUInt32 reg = SHADOW_READ32(owner.shadow, PulserCtrl(id));
 
     inps <<= PulserCtrl_enables_shift;
     inps &= PulserCtrl_enables;
 
     reg &= ~(PulserCtrl_enables);
 
-    WRITE32(owner.base, PulserCtrl(id), reg|inps);
+    SHADOW_WRITE32(owner.shadow, PulserCtrl(id), reg|inps);
 
-    epicsUInt32 rereg = READ32(owner.base, PulserCtrl(id));
+    epicsUInt32 rereg = SHADOW_RELOAD32(owner.shadow, PulserCtrl(id));
 
     if((rereg&PulserCtrl_enables)!=inps)
         throw std::runtime_error("FW doesn't support Pulser enable-gates");
@@ -177,21 +181,21 @@ void MRMPulser::setEnables(epicsUInt32 inps)
 
 epicsUInt32 MRMPulser::masks() const
 {
-    return (READ32(owner.base, PulserCtrl(id)) & PulserCtrl_masks)>>PulserCtrl_masks_shift;
+    return (SHADOW_READ32(owner.shadow, PulserCtrl(id)) & PulserCtrl_masks)>>PulserCtrl_masks_shift;
 }
 
 void MRMPulser::setMasks(epicsUInt32 inps)
 {
-    epicsUInt32 reg = READ32(owner.base, PulserCtrl(id));
+    epicsUInt32 reg = SHADOW_READ32(owner.shadow, PulserCtrl(id));
 
     inps <<= PulserCtrl_masks_shift;
     inps &= PulserCtrl_masks;
 
     reg &= ~(PulserCtrl_masks);
 
-    WRITE32(owner.base, PulserCtrl(id), reg|inps);
+    SHADOW_WRITE32(owner.shadow, PulserCtrl(id), reg|inps);
 
-    epicsUInt32 rereg = READ32(owner.base, PulserCtrl(id));
+    epicsUInt32 rereg = SHADOW_RELOAD32(owner.shadow, PulserCtrl(id));
 
     if((rereg&PulserCtrl_masks)!=inps)
         throw std::runtime_error("FW doesn't support Pulser masking");
@@ -208,9 +212,9 @@ MRMPulser::mappedSource(epicsUInt32 evt) const
 
     epicsUInt32 map[3];
 
-    map[0]=READ32(owner.base, MappingRam(0,evt,Trigger));
-    map[1]=READ32(owner.base, MappingRam(0,evt,Set));
-    map[2]=READ32(owner.base, MappingRam(0,evt,Reset));
+    map[0]=owner.mapWord(evt, EVRMRM::MapTrigger);
+    map[1]=owner.mapWord(evt, EVRMRM::MapSet);
+    map[2]=owner.mapWord(evt, EVRMRM::MapReset);
 
     epicsUInt32 pmask=1<<id, insanity=0;
 
@@ -260,20 +264,9 @@ MRMPulser::sourceSetMap(epicsUInt32 evt,MapType::type action)
     else
         _unmap(evt);
 
-    if(action==MapType::Trigger)
-        BITSET(NAT,32, owner.base, MappingRam(0,evt,Trigger), pmask);
-    else
-        BITCLR(NAT,32, owner.base, MappingRam(0,evt,Trigger), pmask);
-
-    if(action==MapType::Set)
-        BITSET(NAT,32, owner.base, MappingRam(0,evt,Set), pmask);
-    else
-        BITCLR(NAT,32, owner.base, MappingRam(0,evt,Set), pmask);
-
-    if(action==MapType::Reset)
-        BITSET(NAT,32, owner.base, MappingRam(0,evt,Reset), pmask);
-    else
-        BITCLR(NAT,32, owner.base, MappingRam(0,evt,Reset), pmask);
+    owner.mapModify(evt, EVRMRM::MapTrigger, pmask, action==MapType::Trigger);
+    owner.mapModify(evt, EVRMRM::MapSet,     pmask, action==MapType::Set);
+    owner.mapModify(evt, EVRMRM::MapReset,   pmask, action==MapType::Reset);
 }
 
 OBJECT_BEGIN2(MRMPulser, Pulser)
@@ -28,8 +28,9 @@
 #include "evrRegMap.h"
 #include "drvemRxBuf.h"
 
-mrmBufRx::mrmBufRx(const std::string& n, volatile void *b,unsigned int qdepth, unsigned int bsize)
-    :bufRxManager(n, qdepth, bsize)
+mrmBufRx::mrmBufRx(const std::string& n, volatile void *b,unsigned int qdepth, unsigned int bsize,
+                   unsigned int maxdepth)
+    :bufRxManager(n, qdepth, bsize, maxdepth)
     ,base((volatile unsigned char *)b)
 {
 }
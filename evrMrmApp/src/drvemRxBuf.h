@@ -18,7 +18,8 @@
 class epicsShareClass mrmBufRx : public bufRxManager
 {
 public:
-    mrmBufRx(const std::string&, volatile void *base,unsigned int qdepth, unsigned int bsize=0);
+    mrmBufRx(const std::string&, volatile void *base,unsigned int qdepth, unsigned int bsize=0,
+             unsigned int maxdepth=0);
     virtual ~mrmBufRx();
 
     /* no locking needed */
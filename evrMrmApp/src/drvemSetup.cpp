@@ -31,6 +31,7 @@
 #include <mrfCommonIO.h>
 #include <mrfBitOps.h>
 
+#include "mrf/setupqueue.h"
 #include "drvem.h"
 #include "mrfcsr.h"
 #include "mrmpci.h"
@@ -306,6 +307,9 @@ printregisters(volatile epicsUInt8 *evr,epicsUInt32 len)
     }
 }
 
+// drvemSim.cpp
+void mrmEvrSimReport(const EVRMRM *evr);
+
 static
 bool reportCard(mrf::Object* obj, void* raw)
 {
@@ -318,6 +322,8 @@ bool reportCard(mrf::Object* obj, void* raw)
     printf("\tFPGA Version: %08x (firmware: %s)\n", evr->fpgaFirmware(), evr->versionStr().c_str());
     printf("\tForm factor: %s\n", evr->formFactorStr().c_str());
     printf("\tClock: %.6f MHz\n",evr->clock()*1e-6);
+    if(*level>=1)
+        printf("\tShadowed registers: %u\n", (unsigned)evr->shadow.ncached());
 
     bus_configuration *bus = evr->getBusConfiguration();
     if(bus->busType == busType_vme){
@@ -352,6 +358,14 @@ bool reportCard(mrf::Object* obj, void* raw)
         printf("\tPCI configured function: 0x%08x\n", pciDev->function);
         printf("\tPCI in slot: %s\n", pciDev->slot ? pciDev->slot : "<N/A>");
         printf("\tPCI IRQ: %u\n", pciDev->irq);
+        if(evr->irqPoller.get()) {
+            printf("\tPolled every %g s.  %u polls, mean loop %.3f us\n",
+                   evr->irqPoller->pollPeriod(), (unsigned)evr->irqPoller->pollCount(),
+                   evr->irqPoller->loopTime()*1e6);
+        }
+
+    }else if(bus->busType == busType_sim){
+        mrmEvrSimReport(evr);
 
     }else{
         printf("\tUnknown bus type\n");
@@ -360,6 +374,8 @@ bool reportCard(mrf::Object* obj, void* raw)
     if(*level>=2){
         printregisters(evr->base, evr->baselen);
     }
+    if(*level>=1)
+        evr->workerReport();
     if(*level>=1 && evr->sfp.get()){
         evr->sfp->updateNow();
         evr->sfp->report();
@@ -436,6 +452,102 @@ bool checkUIOVersion(int vmin, int vmax, int *actual)
 static bool checkUIOVersion(int,int,int*) {return false;}
 #endif
 
+namespace {
+/* Construction of the EVRMRM and ISR hookup.
+ * Run immediately, or later with other cards (see mrf::SetupQueue)
+ */
+struct evrPCISetup : public mrf::SetupJob
+{
+    bus_configuration bus;
+    const EVRMRM::Config * const conf;
+    volatile epicsUInt8 * const evr;
+    const epicsUInt32 evrlen;
+    const int kifacever;
+
+    evrPCISetup(const char *id, const bus_configuration& bus,
+                const EVRMRM::Config *conf,
+                volatile epicsUInt8 *evr, epicsUInt32 evrlen,
+                int kifacever)
+        :mrf::SetupJob(id)
+        ,bus(bus)
+        ,conf(conf)
+        ,evr(evr)
+        ,evrlen(evrlen)
+        ,kifacever(kifacever)
+    {}
+    virtual ~evrPCISetup() {}
+
+    virtual void run();
+};
+
+void evrPCISetup::run()
+{
+    const epicsPCIDevice *cur = bus.pci.dev;
+
+    // Install ISR
+
+    EVRMRM *receiver=new EVRMRM(name,bus,conf,evr,evrlen);
+
+    void *arg=receiver;
+#ifdef __linux__
+    receiver->isrLinuxPvt = (void*)cur;
+#endif
+
+    if(mrfIRQPoll) {
+        std::string pname(name+":poll");
+        receiver->irqPoller.reset(new IRQPoller(&EVRMRM::isr_poll, arg,
+                                                mrfIRQPollPeriod, mrfIRQPollCPU,
+                                                pname.c_str()));
+        printf("%s: polling every %g s instead of using interrupt\n",
+               name.c_str(), receiver->irqPoller->pollPeriod());
+        return;
+    }
+
+    if(devPCIConnectInterrupt(cur, &EVRMRM::isr_pci, arg, 0)){
+        delete receiver;
+        throw std::runtime_error("Failed to install ISR");
+    }else{
+        // Interrupts will be enabled during iocInit()
+    }
+
+
+#ifndef __linux__
+    if(receiver->version()>=MRFVersion(0, 0xa)) {
+        // RTOS doesn't need this, so always enable
+        WRITE32(evr, PCI_MIE, EVG_MIE_ENABLE);
+    }
+#else
+    if(receiver->version()>=MRFVersion(0, 0xa) && kifacever>=2) {
+        // PCI master enable supported by firmware and kernel module.
+        // the kernel will set this bit when devPCIEnableInterrupt() is called
+    } else if(cur->id.device==PCI_DEVICE_ID_PLX_9030 ||
+              cur->id.device==PCI_DEVICE_ID_PLX_9056) {
+        // PLX based devices don't need special handling
+        WRITE32(evr, PCI_MIE, EVG_MIE_ENABLE);
+    } else if(receiver->version()<MRFVersion(0, 0xa)) {
+        // old firmware and (maybe) old kernel module.
+        // this will still work, so just complain
+        printf("Warning: this configuration of FW and SW is known to have race conditions in interrupt handling.\n"
+                     "         Please consider upgrading to FW version 0xA.\n");
+        if(kifacever<2)
+            printf("         Also upgrade the linux kernel module to interface version 2.");
+    } else if(receiver->version()>=MRFVersion(0, 0xa) && kifacever<2) {
+        // New firmware w/ old kernel module, this won't work
+        throw std::runtime_error("FW version 0xA for this device requires a linux kernel module w/ interface version 2");
+    } else {
+        throw std::logic_error("logic error in FW/kernel module compatibility check.");
+    }
+
+    /* ask the kernel module to enable interrupts */
+    printf("Enabling interrupts\n");
+    if(devPCIEnableInterrupt(cur)) {
+        delete receiver;
+        throw std::runtime_error("Failed to enable interrupt");
+    }
+#endif
+}
+} // namespace
+
 void
 mrmEvrSetupPCI(const char* id,const char* pcispec)
 {
@@ -607,59 +719,7 @@ try {
     //TODO: This avoids a spurious FIFO Full
     NAT_WRITE32(evr, IRQFlag, NAT_READ32(evr, IRQFlag));
 
-    // Install ISR
-
-    EVRMRM *receiver=new EVRMRM(id,bus,conf,evr,evrlen);
-
-    void *arg=receiver;
-#ifdef __linux__
-    receiver->isrLinuxPvt = (void*)cur;
-#endif
-
-    if(devPCIConnectInterrupt(cur, &EVRMRM::isr_pci, arg, 0)){
-        printf("Failed to install ISR\n");
-        delete receiver;
-        return;
-    }else{
-        // Interrupts will be enabled during iocInit()
-    }
-
-
-#ifndef __linux__
-    if(receiver->version()>=MRFVersion(0, 0xa)) {
-        // RTOS doesn't need this, so always enable
-        WRITE32(evr, PCI_MIE, EVG_MIE_ENABLE);
-    }
-#else
-    if(receiver->version()>=MRFVersion(0, 0xa) && kifacever>=2) {
-        // PCI master enable supported by firmware and kernel module.
-        // the kernel will set this bit when devPCIEnableInterrupt() is called
-    } else if(cur->id.device==PCI_DEVICE_ID_PLX_9030 ||
-              cur->id.device==PCI_DEVICE_ID_PLX_9056) {
-        // PLX based devices don't need special handling
-        WRITE32(evr, PCI_MIE, EVG_MIE_ENABLE);
-    } else if(receiver->version()<MRFVersion(0, 0xa)) {
-        // old firmware and (maybe) old kernel module.
-        // this will still work, so just complain
-        printf("Warning: this configuration of FW and SW is known to have race conditions in interrupt handling.\n"
-                     "         Please consider upgrading to FW version 0xA.\n");
-        if(kifacever<2)
-            printf("         Also upgrade the linux kernel module to interface version 2.");
-    } else if(receiver->version()>=MRFVersion(0, 0xa) && kifacever<2) {
-        // New firmware w/ old kernel module, this won't work
-        throw std::runtime_error("FW version 0xA for this device requires a linux kernel module w/ interface version 2");
-    } else {
-        throw std::logic_error("logic error in FW/kernel module compatibility check.");
-    }
-
-    /* ask the kernel module to enable interrupts */
-    printf("Enabling interrupts\n");
-    if(devPCIEnableInterrupt(cur)) {
-        printf("Failed to enable interrupt\n");
-        delete receiver;
-        return;
-    }
-#endif
+    mrf::SetupQueue::submit(new evrPCISetup(id, bus, conf, evr, evrlen, kifacever));
 
 } catch(std::exception& e) {
     printf("Error: %s\n",e.what());
@@ -712,6 +772,23 @@ disableIRQ(mrf::Object* obj, void*)
     return true;
 }
 
+static
+bool
+commitMap(mrf::Object* obj, void*)
+{
+    EVRMRM *mrm=dynamic_cast<EVRMRM*>(obj);
+    if(!mrm)
+        return true;
+
+    // initial mapping is deferred from construction.  cf. EVRMRM::mapDefer()
+    try {
+        mrm->mapCommit();
+    } catch(std::exception& e) {
+        printf("%s: Error: %s\n", mrm->name().c_str(), e.what());
+    }
+    return true;
+}
+
 static
 void
 evrShutdown(void*)
@@ -719,6 +796,8 @@ evrShutdown(void*)
     mrf::Object::visitObjects(&disableIRQ,0);
 }
 
+static bool mapCommitted;
+
 void mrmEvrInithooks(initHookState state)
 {
     epicsUInt8 lvl;
@@ -742,6 +821,14 @@ void mrmEvrInithooks(initHookState state)
 
         }
 
+        break;
+    case initHookAfterIocRunning:
+        // Write the mapping set by PINI processing in one pass.
+        // Not again when resumed after iocPause()
+        if(!mapCommitted) {
+            mapCommitted = true;
+            mrf::Object::visitObjects(&commitMap,0);
+        }
         break;
   default:
         break;
@@ -749,6 +836,59 @@ void mrmEvrInithooks(initHookState state)
 }
 
 
+namespace {
+struct evrVMESetup : public mrf::SetupJob
+{
+    bus_configuration bus;
+    const EVRMRM::Config * const conf;
+    volatile epicsUInt8 * const evr;
+    volatile unsigned char * const user_csr;
+
+    evrVMESetup(const char *id, const bus_configuration& bus,
+                const EVRMRM::Config *conf,
+                volatile epicsUInt8 *evr,
+                volatile unsigned char *user_csr)
+        :mrf::SetupJob(id)
+        ,bus(bus)
+        ,conf(conf)
+        ,evr(evr)
+        ,user_csr(user_csr)
+    {}
+    virtual ~evrVMESetup() {}
+
+    virtual void run();
+};
+
+void evrVMESetup::run()
+{
+    const int level = bus.vme.irqLevel, vector = bus.vme.irqVector;
+
+    EVRMRM *receiver=new EVRMRM(name, bus, conf, evr, EVR_REGMAP_SIZE);
+
+    if(level>0 && vector>=0) {
+        CSRWrite8(user_csr+UCSR_IRQ_LEVEL,  level&0x7);
+        CSRWrite8(user_csr+UCSR_IRQ_VECTOR, vector&0xff);
+
+        printf("Using IRQ %d:%2d\n",
+               CSRRead8(user_csr+UCSR_IRQ_LEVEL),
+               CSRRead8(user_csr+UCSR_IRQ_VECTOR)
+               );
+
+        // Acknowledge missed interrupts
+        //TODO: This avoids a spurious FIFO Full
+        NAT_WRITE32(evr, IRQFlag, NAT_READ32(evr, IRQFlag));
+
+        if(devConnectInterruptVME(vector&0xff, &EVRMRM::isr_vme, receiver))
+        {
+            delete receiver;
+            throw std::runtime_error("Failed to connect VME IRQ");
+        }
+
+        // Interrupts will be enabled during iocInit()
+    }
+}
+} // namespace
+
 void
 mrmEvrSetupVME(const char* id,int slot,int base,int level, int vector)
 {
@@ -831,35 +971,13 @@ try {
 
     NAT_WRITE32(evr, IRQEnable, 0); // Disable interrupts
 
-    EVRMRM *receiver=new EVRMRM(id, bus, conf, evr, EVR_REGMAP_SIZE);
-
     if(level>0 && vector>=0) {
-        CSRWrite8(user_csr+UCSR_IRQ_LEVEL,  level&0x7);
-        CSRWrite8(user_csr+UCSR_IRQ_VECTOR, vector&0xff);
-
-        printf("Using IRQ %d:%2d\n",
-               CSRRead8(user_csr+UCSR_IRQ_LEVEL),
-               CSRRead8(user_csr+UCSR_IRQ_VECTOR)
-               );
-
-        // Acknowledge missed interrupts
-        //TODO: This avoids a spurious FIFO Full
-        NAT_WRITE32(evr, IRQFlag, NAT_READ32(evr, IRQFlag));
-
-        level&=0x7;
         // VME IRQ level will be enabled later during iocInit()
-        vme_level_mask|=1<<(level-1);
-
-        if(devConnectInterruptVME(vector&0xff, &EVRMRM::isr_vme, receiver))
-        {
-            printf("Failed to connection VME IRQ %d\n",vector&0xff);
-            delete receiver;
-            return;
-        }
-
-        // Interrupts will be enabled during iocInit()
+        vme_level_mask|=1<<((level&0x7)-1);
     }
 
+    mrf::SetupQueue::submit(new evrVMESetup(id, bus, conf, evr, user_csr));
+
 } catch(std::exception& e) {
     printf("Error: %s\n",e.what());
 }
@@ -877,7 +995,8 @@ try {
     if(!card)
         throw std::runtime_error("Not a MRM EVR");
 
-    printf("Print ram #%d\n",ram);
+    printf("Print ram #%d%s\n",ram,
+           unsigned(ram)==card->mapBankActive() ? " (active)" : "");
     if(evt>=0){
         // Print a single event
         printRamEvt(card,evt,ram);
@@ -1010,3 +1129,126 @@ try {
     printf("Error: %s\n",e.what());
 }
 }
+
+/** @brief Print event latency histograms
+ *
+ * Requires that "Latency Enable" be set ($(P)LatHist:Ena-Sel).
+ *
+ @param id EVR identifier
+ @param evt Event code, or 0 for all codes with data
+ */
+void
+mrmEvrLatencyReport(const char* id, int evt)
+{
+try {
+    mrf::Object *obj=mrf::Object::getObject(id);
+    if(!obj)
+        throw std::runtime_error("Object not found");
+    EVRMRM *card=dynamic_cast<EVRMRM*>(obj);
+    if(!card)
+        throw std::runtime_error("Not a MRM EVR");
+
+    if(evt<0 || evt>255)
+        throw std::runtime_error("Invalid event code");
+
+    card->latencyReport(evt);
+
+} catch(std::exception& e) {
+    printf("Error: %s\n",e.what());
+}
+}
+
+/** @brief Run the I/O Intr scans of some event codes in a dedicated thread
+ *
+ * Records with SCAN="I/O Intr" on the listed event codes are processed
+ * by a new thread owned by the EVR instead of the shared callback queues.
+ * Requires Base >= 3.16.1.  Should be called before iocInit().
+ *
+ @code
+   > mrmEvrEventWorker("EVR1", "14, 0x7d", 91, 2) # prio 91 on CPU 2
+ @endcode
+ *
+ @param id EVR identifier
+ @param events A string with a comma seperated list of event numbers
+ @param prio EPICS thread priority (0-99)
+ @param cpu CPU to run on (Linux only), or -1 for any
+ */
+void
+mrmEvrEventWorker(const char* id, const char* events_iocsh, int prio, int cpu)
+{
+    char *events=events_iocsh ? epicsStrDup(events_iocsh) : 0;
+try {
+    mrf::Object *obj=mrf::Object::getObject(id);
+    if(!obj)
+        throw std::runtime_error("Object not found");
+    EVRMRM *card=dynamic_cast<EVRMRM*>(obj);
+    if(!card)
+        throw std::runtime_error("Not a MRM EVR");
+
+    if(!events || strlen(events)==0)
+        throw std::runtime_error("No events given");
+    if(prio<0 || prio>99)
+        throw std::runtime_error("Priority must be in range [0, 99]");
+
+    std::vector<epicsUInt8> codes;
+
+    const char sep[]=", ";
+    char *save=0;
+
+    for(char *tok=strtok_r(events, sep, &save);
+        tok!=NULL;
+        tok = strtok_r(0, sep, &save)
+        )
+    {
+        char *end=0;
+        long e=strtol(tok, &end, 0);
+        if(*end || e<=0 || e>255)
+            throw std::runtime_error(SB()<<"Invalid event spec '"<<tok<<"'");
+        codes.push_back(e);
+    }
+
+    card->bindWorker(codes, prio, cpu);
+
+    free(events);
+} catch(std::exception& e) {
+    printf("Error: %s\n",e.what());
+    free(events);
+}
+}
+
+/** @brief Defer, then commit, a batch of mapping RAM changes
+ *
+ * Changes to the mapping made between the two calls are written
+ * together, and take effect at once (see evrMrmMapBankSwitch).
+ * The initial configuration is already batched this way
+ * until the IOC is running.
+ *
+ @code
+   > mrmEvrMapDefer("EVR1", 1)
+   > dbpf ...
+   > mrmEvrMapDefer("EVR1", 0)
+ @endcode
+ *
+ @param id EVR identifier
+ @param defer 1 to begin a batch, 0 to write it
+ */
+void
+mrmEvrMapDefer(const char* id, int defer)
+{
+try {
+    mrf::Object *obj=mrf::Object::getObject(id);
+    if(!obj)
+        throw std::runtime_error("Object not found");
+    EVRMRM *card=dynamic_cast<EVRMRM*>(obj);
+    if(!card)
+        throw std::runtime_error("Not a MRM EVR");
+
+    if(defer)
+        card->mapDefer();
+    else
+        card->mapCommit();
+
+} catch(std::exception& e) {
+    printf("Error: %s\n",e.what());
+}
+}
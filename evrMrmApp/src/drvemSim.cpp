@@ -0,0 +1,546 @@
+/*************************************************************************\
+* mrfioc2 is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/* A simulated EVR for testing without hardware.
+ *
+ * The register map is host memory.  Registers with side effects
+ * (FIFO, IRQ flags, timestamp counters and latch, data buffer Tx)
+ * are emulated through the hooks of mrf/simio.h, so this is only
+ * functional when built with MRF_SIM_IO=YES.
+ *
+ * A generator thread produces events at configured rates, plus
+ * the seconds tick (0x7D) from the host clock, in time order.
+ * Events with the FIFO save action mapped are placed in the FIFO.
+ * A data buffer sent is looped back to the receiver.
+ *
+ * Sequencer 0 runs from its RAM when software triggered (cf. SeqSim),
+ * and its events are received like those from the generator, with start
+ * and end of sequence interrupts.  Other RAMs are plain memory.
+ *
+ * Registers are accessed with evrLock held, and generalTime may call
+ * the EVR time provider which takes evrLock.  So register accesses use
+ * a host time reference sampled by the generator thread, and never
+ * call generalTime.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <stdexcept>
+#include <vector>
+
+#include <epicsVersion.h>
+#include <epicsString.h>
+#include <epicsThread.h>
+#include <epicsEvent.h>
+#include <epicsMutex.h>
+#include <epicsTime.h>
+#include <generalTimeSup.h>
+#include <errlog.h>
+
+#include <mrfCommon.h>
+#include <mrfCommonIO.h>
+#include <mrfFracSynth.h>
+#include "mrf/simio.h"
+#include "mrmSeqSim.h"
+
+#include "evrRegMap.h"
+#include "drvem.h"
+#include "drvemIocsh.h"
+
+namespace {
+
+const EVRMRM::Config sim_evr = {
+    "Sim-EVR",
+    16, // pulse generators
+    3,  // prescalers
+    4,  // FP outputs
+    0,  // FPUV outputs
+    0,  // RB outputs
+    0,  // Backplane outputs
+    0,  // FP Delay outputs
+    0,  // CML/GTX outputs
+    MRMCML::typeCML,
+    2,  // FP inputs
+};
+
+// firmware 2.7.6, PCIe form factor
+const epicsUInt32 simFWVersion = (1u<<FWVersion_type_shift)
+                               | (formFactor_PCIe<<FWVersion_form_shift)
+                               | 0x00060207;
+
+const double simEventClock = 124.916; // MHz
+const double simFracRef = 24.0; // MHz
+
+const size_t simFIFODepth = 511;
+
+// Bounds the work done in one wakeup if the generator falls behind
+const size_t simMaxBatch = 4096;
+
+struct simSource {
+    epicsUInt8 code;
+    double period; // seconds
+    double next;   // seconds since start
+};
+
+struct simEntry {
+    epicsUInt32 code, sec, evt;
+};
+
+struct EVRSim : public epicsThreadRunable
+{
+    epicsUInt32 *regs;
+
+    mutable epicsMutex lock;
+    epicsEvent wakeup;
+    bool stop;
+
+    // guarded by lock
+    epicsUInt32 irqflags;
+    std::vector<simEntry> fifo;
+    size_t fifoIn, fifoOut, fifoCnt;
+    epicsUInt32 lastSec;
+    epicsUInt64 count_events, count_dropped, count_behind, count_seq;
+    // seconds since start
+    SeqSim seq;
+    // host time reference.  cf. sampleHost()
+    epicsTimeStamp refTime;
+    epicsUInt64 refMono;
+
+    std::vector<simSource> sources;
+    epicsTimeStamp start;
+    const double tickPeriod;
+
+    EVRMRM *evr;
+
+    epicsThread runner;
+
+    static epicsUInt32* allocRegs()
+    {
+        epicsUInt32 *regs = (epicsUInt32*)calloc(EVR_REGMAP_SIZE/4, 4);
+        if(!regs)
+            throw std::bad_alloc();
+        return regs;
+    }
+
+    EVRSim(const std::vector<simSource>& sources, double tickPeriod)
+        :regs(allocRegs())
+        ,stop(false)
+        ,irqflags(0)
+        ,fifo(simFIFODepth)
+        ,fifoIn(0), fifoOut(0), fifoCnt(0)
+        ,lastSec(0)
+        ,count_events(0), count_dropped(0), count_behind(0), count_seq(0)
+        ,seq(&reg(U32_SeqControl(0)), &reg(U32_SeqRamTS(0, 0)), 63)
+        ,refMono(0u)
+        ,sources(sources)
+        ,tickPeriod(tickPeriod)
+        ,evr(0)
+        ,runner(*this, "EVRSim",
+                epicsThreadGetStackSize(epicsThreadStackSmall),
+                epicsThreadPriorityHigh)
+    {
+        double err;
+        reg(U32_FWVersion) = simFWVersion;
+        reg(U32_FracDiv) = FracSynthControlWord(simEventClock, simFracRef, 0, &err);
+        reg(U32_USecDiv) = epicsUInt32(simEventClock);
+        reg(U32_CounterPS) = 1u; // TS clock is event clock
+        reg(U32_ClkCtrl) = ClkCtrl_plllock|ClkCtrl_cglock;
+
+        sampleHost();
+        start = refTime;
+        lastSec = start.secPastEpoch;
+
+        mrfSimIORegister(regs, EVR_REGMAP_SIZE, &access, this);
+    }
+    virtual ~EVRSim() {}
+
+    epicsUInt32& reg(epicsUInt32 off) { return regs[off/4]; }
+
+    // host time, POSIX epoch.  Call with no locks held.
+    static void now(epicsTimeStamp *ts)
+    {
+        // any provider except the EVR we are simulating
+        if(epicsTimeOK != generalTimeGetExceptPriority(ts, 0, ER_PROVIDER_PRIORITY))
+            throw std::runtime_error("No time provider");
+        ts->secPastEpoch += POSIX_TIME_AT_EPICS_EPOCH;
+    }
+
+    // Update the reference for hostTime().  Call with no locks held.
+    void sampleHost()
+    {
+        epicsTimeStamp T;
+        now(&T);
+        SCOPED_LOCK(lock);
+        refTime = T;
+#if EPICS_VERSION_INT>=VERSION_INT(3,16,1,0)
+        refMono = epicsMonotonicGet();
+#endif
+    }
+
+    // host time, POSIX epoch.  caller must hold lock.
+    // Extrapolated from the last sampleHost() when epicsMonotonicGet()
+    // is available, otherwise as of the last generator wakeup.
+    void hostTime(epicsTimeStamp *ts)
+    {
+        *ts = refTime;
+#if EPICS_VERSION_INT>=VERSION_INT(3,16,1,0)
+        epicsTimeAddSeconds(ts, (epicsMonotonicGet()-refMono)*1e-9);
+#endif
+    }
+
+    // caller must hold lock
+    double evtClkHz()
+    {
+        return FracSynthAnalyze(reg(U32_FracDiv), simFracRef, 0)*1e6;
+    }
+
+    // caller must hold lock
+    double tickHz()
+    {
+        double clk = evtClkHz();
+        epicsUInt32 div = reg(U32_CounterPS);
+        return div ? clk/div : clk;
+    }
+
+    // caller must hold lock
+    void push(epicsUInt8 code, const epicsTimeStamp& ts, double hz)
+    {
+        count_events++;
+
+        if(!(reg(U32_Control)&Control_enable))
+            return;
+
+        unsigned bank = (reg(U32_Control)&Control_mapsel) ? 1 : 0;
+        epicsUInt32 internal = reg(U32__MappingRam(bank, code, MappingRamBlockInternal));
+        if(!(internal & (1u<<(ActionFIFOSave%32))))
+            return;
+
+        if(fifoCnt==simFIFODepth) {
+            count_dropped++;
+            irqflags |= IRQ_FIFOFull;
+            return;
+        }
+
+        simEntry& E = fifo[fifoIn];
+        E.code = code;
+        E.sec = ts.secPastEpoch;
+        E.evt = epicsUInt32(ts.nsec*1e-9*hz);
+        fifoIn = (fifoIn+1)%simFIFODepth;
+        fifoCnt++;
+        irqflags |= IRQ_Event;
+    }
+
+    // caller must hold lock
+    bool irqPending()
+    {
+        epicsUInt32 ena = reg(U32_IRQEnable);
+        return (ena&IRQ_Enable) && (irqflags&ena&0xffff);
+    }
+
+    // caller must hold lock.  flags from SeqSim
+    void seqFlags(unsigned flags)
+    {
+        if(flags&SeqSim::Ended)
+            irqflags |= IRQ_EoS;
+        if(flags&SeqSim::Started) {
+            count_seq++;
+            irqflags |= IRQ_SoS;
+        }
+    }
+
+    void generate()
+    {
+        sampleHost();
+
+        SCOPED_LOCK(lock);
+        epicsTimeStamp T;
+        hostTime(&T);
+        const double elapsed = epicsTimeDiffInSeconds(&T, &start);
+        const double hz = tickHz(), clk = evtClkHz();
+
+        // Missed ticks are skipped
+        bool tick = T.secPastEpoch!=lastSec;
+        epicsTimeStamp tickTS = T;
+        tickTS.nsec = 0;
+        const double tickAt = epicsTimeDiffInSeconds(&tickTS, &start);
+
+        // Take the earliest due of the sources, the sequencer, and the
+        // seconds tick, so the FIFO is in time order.
+        for(size_t n=0; ; n++) {
+            simSource *S = 0;
+            for(size_t i=0; i<sources.size(); i++) {
+                if(sources[i].next<=elapsed && (!S || sources[i].next<S->next))
+                    S = &sources[i];
+            }
+            double seqAt = 0.0;
+            const bool seqDue = seq.next(clk, seqAt) && seqAt<=elapsed;
+
+            if(!S && !seqDue && !tick)
+                break;
+
+            if(n==simMaxBatch) {
+                // skip ahead.  The sequencer resumes on the next wakeup
+                count_behind++;
+                for(size_t i=0; i<sources.size(); i++) {
+                    if(sources[i].next<=elapsed)
+                        sources[i].next = elapsed+sources[i].period;
+                }
+                break;
+            }
+
+            if(tick && (!S || tickAt<=S->next) && (!seqDue || tickAt<=seqAt)) {
+                tick = false;
+                lastSec = T.secPastEpoch;
+                push(MRF_EVENT_TS_COUNTER_RST, tickTS, hz);
+
+            } else if(seqDue && (!S || seqAt<=S->next)) {
+                epicsUInt8 code;
+                seqFlags(seq.step(clk, seqAt, &code));
+                if(code) {
+                    epicsTimeStamp ets = start;
+                    epicsTimeAddSeconds(&ets, seqAt);
+                    push(code, ets, hz);
+                }
+
+            } else {
+                epicsTimeStamp ets = start;
+                epicsTimeAddSeconds(&ets, S->next);
+                push(S->code, ets, hz);
+                S->next += S->period;
+            }
+        }
+    }
+
+    virtual void run()
+    {
+        while(true) {
+            wakeup.wait(tickPeriod);
+            {
+                SCOPED_LOCK(lock);
+                if(stop)
+                    break;
+            }
+
+            generate();
+
+            bool raise;
+            {
+                SCOPED_LOCK(lock);
+                raise = irqPending();
+            }
+            // as if from the interrupt.  Not while holding our lock.
+            if(raise)
+                EVRMRM::isr_poll(evr);
+        }
+    }
+
+    // caller must hold lock
+    void loopbackTx(epicsUInt32 ctrl)
+    {
+        epicsUInt32 len = ctrl&DataTxCtrl_len_mask;
+        epicsUInt32 rx = reg(U32_DataBufCtrl);
+
+        if((rx&DataBufCtrl_mode) && (rx&DataBufCtrl_rx)) {
+            memcpy(&reg(U32_DataRx(0)), &reg(U32_DataTx(0)), len);
+            rx &= ~(DataBufCtrl_rx|DataBufCtrl_sumerr|DataBufCtrl_len_mask);
+            reg(U32_DataBufCtrl) = rx|len;
+            irqflags |= IRQ_BufFull;
+        }
+        reg(U32_DataTxCtrl) = (ctrl&~(DataTxCtrl_trig|DataTxCtrl_run))|DataTxCtrl_done;
+    }
+
+    void access32(epicsUInt32 offset, bool write, epicsUInt32 *val, bool& handled)
+    {
+        handled = true;
+        SCOPED_LOCK(lock);
+
+        if(!write) {
+            switch(offset) {
+            case U32_IRQFlag:
+                *val = irqflags;
+                return;
+            case U32_EvtFIFOCode:
+                if(!fifoCnt) {
+                    *val = 0;
+                } else {
+                    const simEntry& E = fifo[fifoOut];
+                    *val = E.code;
+                    reg(U32_EvtFIFOSec) = E.sec;
+                    reg(U32_EvtFIFOEvt) = E.evt;
+                    fifoOut = (fifoOut+1)%simFIFODepth;
+                    fifoCnt--;
+                }
+                if(!fifoCnt)
+                    irqflags &= ~IRQ_Event;
+                return;
+            case U32_TSSec:
+            case U32_TSEvt: {
+                epicsTimeStamp T;
+                hostTime(&T);
+                *val = offset==U32_TSSec ? T.secPastEpoch : epicsUInt32(T.nsec*1e-9*tickHz());
+                return;
+            }
+            case U32_SeqControl(0):
+                *val = seq.readCtrl();
+                return;
+            }
+
+        } else {
+            switch(offset) {
+            case U32_IRQFlag:
+                // write 1 to clear.  FIFO not empty is level
+                irqflags &= ~*val;
+                if(fifoCnt)
+                    irqflags |= IRQ_Event;
+                return;
+            case U32_IRQEnable:
+                reg(offset) = *val;
+                // re-enabled with flags still set
+                if(irqPending())
+                    wakeup.signal();
+                return;
+            case U32_Control:
+                if(*val&Control_tsltch) {
+                    epicsTimeStamp T;
+                    hostTime(&T);
+                    reg(U32_TSSecLatch) = T.secPastEpoch;
+                    reg(U32_TSEvtLatch) = epicsUInt32(T.nsec*1e-9*tickHz());
+                }
+                if(*val&Control_fiforst) {
+                    fifoIn = fifoOut = fifoCnt = 0;
+                    irqflags &= ~(IRQ_Event|IRQ_FIFOFull);
+                }
+                // action bits are write only
+                reg(offset) = *val&~(Control_tsltch|Control_fiforst|Control_tsrst|Control_logrst|Control_sreset);
+                return;
+            case U32_DataTxCtrl:
+                if(*val&DataTxCtrl_trig)
+                    loopbackTx(*val);
+                else
+                    reg(offset) = *val;
+                return;
+            case U32_SeqControl(0): {
+                epicsTimeStamp T;
+                hostTime(&T);
+                const unsigned flags = seq.writeCtrl(*val, epicsTimeDiffInSeconds(&T, &start));
+                seqFlags(flags);
+                if(flags)
+                    wakeup.signal();
+                return;
+            }
+            }
+        }
+        handled = false;
+    }
+
+    static int access(void *pvt, epicsUInt32 offset, unsigned width,
+                      int write, epicsUInt32 *val)
+    {
+        EVRSim *self = static_cast<EVRSim*>(pvt);
+        bool handled = false;
+        if(width==32)
+            self->access32(offset, write, val, handled);
+        return handled;
+    }
+
+    void report() const
+    {
+        SCOPED_LOCK(lock);
+        printf("\tSimulated.  %llu events, %llu dropped (FIFO full), behind %llu times, %llu sequences\n",
+               (unsigned long long)count_events,
+               (unsigned long long)count_dropped,
+               (unsigned long long)count_behind,
+               (unsigned long long)count_seq);
+        for(size_t i=0; i<sources.size(); i++)
+            printf("\t  code %3u at %g Hz\n", sources[i].code, 1.0/sources[i].period);
+    }
+};
+
+// only added to before iocInit()
+std::vector<EVRSim*> sims;
+
+} // namespace
+
+/** @brief Setup a simulated EVR
+ *
+ * Requires a build with MRF_SIM_IO=YES.
+ * Sequences loaded through the EVR's SeqManager run when software triggered.
+ *
+ @code
+   > mrmEvrSetupSim("EVR1", "14@14, 0x20@10000", 0.001)
+ @endcode
+ *
+ @param id EVR identifier
+ @param events A comma seperated list of event codes and rates in Hz as "code@rate".
+               The seconds tick event (0x7D) is always generated.
+ @param period Generator wakeup interval in seconds.  0 for 1 ms.
+ */
+void
+mrmEvrSetupSim(const char* id, const char* events_iocsh, double period)
+{
+    char *events=events_iocsh ? epicsStrDup(events_iocsh) : 0;
+try {
+#ifndef MRF_SIM_IO
+    throw std::runtime_error("Simulation requires a build with MRF_SIM_IO=YES");
+#endif
+    if(mrf::Object::getObject(id))
+        throw std::runtime_error("Object ID already in use");
+
+    if(period<=0.0)
+        period = 0.001;
+
+    std::vector<simSource> sources;
+
+    const char sep[]=", ";
+    char *save=0;
+
+    for(char *tok=events ? strtok_r(events, sep, &save) : 0;
+        tok!=NULL;
+        tok = strtok_r(0, sep, &save)
+        )
+    {
+        char *end=0;
+        long code=strtol(tok, &end, 0);
+        double rate=0.0;
+        if(*end=='@')
+            rate=strtod(end+1, &end);
+        if(*end || code<=0 || code>255 || !(rate>0.0))
+            throw std::runtime_error(SB()<<"Invalid event spec '"<<tok<<"'");
+
+        simSource S;
+        S.code = epicsUInt8(code);
+        S.period = 1.0/rate;
+        S.next = 0.0;
+        sources.push_back(S);
+    }
+
+    // Never freed, the simulated register map must outlive the EVRMRM
+    EVRSim *sim = new EVRSim(sources, period);
+
+    bus_configuration bus;
+    bus.busType = busType_sim;
+
+    sim->evr = new EVRMRM(id, bus, &sim_evr,
+                          (volatile unsigned char*)sim->regs, EVR_REGMAP_SIZE);
+    sims.push_back(sim);
+
+    sim->runner.start();
+
+    free(events);
+} catch(std::exception& e) {
+    printf("Error: %s\n",e.what());
+    free(events);
+}
+}
+
+void
+mrmEvrSimReport(const EVRMRM *evr)
+{
+    for(size_t i=0; i<sims.size(); i++) {
+        if(sims[i]->evr==evr)
+            sims[i]->report();
+    }
+}
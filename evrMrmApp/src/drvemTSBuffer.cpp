@@ -4,6 +4,18 @@
 * in file LICENSE that is included with this distribution.
 \*************************************************************************/
 
+#include <cstring>
+#include <cerrno>
+#include <sstream>
+
+#ifdef __linux__
+#  include <sys/types.h>
+#  include <sys/stat.h>
+#  include <sys/mman.h>
+#  include <fcntl.h>
+#  include <unistd.h>
+#endif
+
 #include "drvem.h"
 #include "drvemTSBuffer.h"
 #include "devObj.h"
@@ -15,13 +27,20 @@ EVRMRMTSBuffer::EVRMRMTSBuffer(const std::string &n, EVRMRM *evr)
     ,timeEvt(0u)
     ,flushEvt(0u)
     ,active(0u)
+    ,ring(0)
+    ,ringCap(0u)
+    ,ringPos(0u)
+    ,ringTotal(0u)
+    ,ringLostCnt(0u)
+    ,ringHdr(0)
+    ,ringMapLen(0u)
 {
     scanIoInit(&scan);
 }
 
 EVRMRMTSBuffer::~EVRMRMTSBuffer()
 {
-
+    ringFree();
 }
 
 void EVRMRMTSBuffer::lock() const
@@ -98,17 +117,137 @@ void EVRMRMTSBuffer::doFlush()
     ebufs[active].prevok = prevok;
     ebufs[active].prevflushtime = prevflushtime;
 
+    ringTickHz();
+
     scanIoRequest(scan);
 }
 
+void EVRMRMTSBuffer::ringFree()
+{
+#ifdef __linux__
+    if(ringHdr)
+        munmap((void*)ringHdr, ringMapLen);
+#endif
+    ringHdr = 0;
+    ringMapLen = 0u;
+    std::vector<epicsTimeStamp>().swap(ringmem);
+    ring = 0;
+    ringCap = ringPos = 0u;
+    ringTotal = ringLostCnt = 0u;
+    cursors.clear();
+}
+
+void EVRMRMTSBuffer::ringTickHz() const
+{
+    if(ringHdr)
+        ringHdr->tickHz = evr->clockTS();
+}
+
+void EVRMRMTSBuffer::ringSizeSet(epicsUInt32 n)
+{
+    if(n==ringCap)
+        return;
+    ringFree();
+    if(!n)
+        return;
+
+    if(ringFileName.empty()) {
+        ringmem.resize(n);
+        ring = &ringmem[0];
+
+    } else {
+#ifdef __linux__
+        const size_t len = sizeof(EVRMRMTSRingHeader) + n*sizeof(epicsTimeStamp);
+
+        int fd = open(ringFileName.c_str(), O_RDWR|O_CREAT|O_TRUNC, 0644);
+        void *mem = MAP_FAILED;
+        if(fd>=0 && ftruncate(fd, len)==0)
+            mem = mmap(0, len, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+        int err = errno;
+        if(fd>=0)
+            close(fd);
+
+        if(mem==MAP_FAILED) {
+            std::ostringstream msg;
+            msg<<"Can't map "<<ringFileName<<" : "<<strerror(err);
+            throw std::runtime_error(msg.str());
+        }
+        // fault in all pages now, not while capturing
+        memset(mem, 0, len);
+
+        ringHdr = (EVRMRMTSRingHeader*)mem;
+        memcpy(ringHdr->magic, "MRFTSRNG", sizeof(ringHdr->magic));
+        ringHdr->version = 1u;
+        ringHdr->capacity = n;
+        ringHdr->count = 0u;
+        ringMapLen = len;
+        ring = (epicsTimeStamp*)(ringHdr+1);
+#else
+        throw std::runtime_error("File backed capture ring not supported on this target");
+#endif
+    }
+    ringCap = n;
+    ringTickHz();
+}
+
+void EVRMRMTSBuffer::ringFileSet(std::string f)
+{
+    if(f==ringFileName)
+        return;
+    size_t n = ringCap;
+    ringFree();
+    ringFileName = f;
+    ringSizeSet(n);
+}
+
 enum TimesRef {
     TimesRefEvt0,
     TimesRefFlush,
     TimesRefPrevFlush,
 };
 
+static inline
+void storeNS(epicsInt32& out, epicsInt64 ns)
+{
+    // saturate rather than wrap intervals longer than ~2.1 sec.
+    if(ns > 0x7fffffff)
+        ns = 0x7fffffff;
+    else if(ns < -0x7fffffff-1)
+        ns = -0x7fffffff-1;
+    out = epicsInt32(ns);
+}
+
+static inline
+void storeNS(epicsInt64& out, epicsInt64 ns)
+{
+    out = ns;
+}
+
+static inline
+void storeNS(double& out, epicsInt64 ns)
+{
+    out = double(ns);
+}
+
+// ns since the POSIX epoch of a captured (POSIX sec, tick) pair.
+// scale from EVRMRM::tsTickScale()
+static inline
+epicsInt64 tickNS(const epicsTimeStamp& ts, epicsUInt64 scale)
+{
+    return epicsInt64(ts.secPastEpoch)*1000000000 + EVRMRM::ticks2ns(ts.nsec, scale);
+}
+
+template<typename T>
+static inline
+void convertNS(T *arr, const epicsTimeStamp *src, size_t n, epicsUInt64 scale, epicsInt64 off)
+{
+    for(size_t i=0; i<n; i++)
+        storeNS(arr[i], tickNS(src[i], scale) - off);
+}
+
+template<typename T>
 static
-epicsUInt32 getTimes(const EVRMRMTSBuffer* self, epicsInt32 *arr, epicsUInt32 count, TimesRef ref)
+epicsUInt32 getTimes(const EVRMRMTSBuffer* self, T *arr, epicsUInt32 count, TimesRef ref)
 {
     const EVRMRMTSBuffer::ebuf_t& readout = self->ebufs[self->active^1u];
     dbCommon* prec = CurrentRecord::get();
@@ -121,7 +260,7 @@ epicsUInt32 getTimes(const EVRMRMTSBuffer* self, epicsInt32 *arr, epicsUInt32 co
         recGblSetSevr(prec, READ_ALARM, MAJOR_ALARM);
     }
 
-    double period=1e9/self->evr->clockTS(); // in nanoseconds
+    const epicsUInt64 scale = self->evr->tsTickScale();
 
     size_t len = std::min(readout.pos, size_t(count));
 
@@ -129,7 +268,7 @@ epicsUInt32 getTimes(const EVRMRMTSBuffer* self, epicsInt32 *arr, epicsUInt32 co
         const_cast<EVRMRMTSBuffer::ebuf_t&>(readout).buf.resize(count);
     }
 
-    if(period<=0 || !isfinite(period)) {
+    if(!scale) {
         if(count>0u) {
             arr[0] = 0;
             count = 1u;
@@ -138,28 +277,24 @@ epicsUInt32 getTimes(const EVRMRMTSBuffer* self, epicsInt32 *arr, epicsUInt32 co
         return count;
     }
 
-    epicsTimeStamp tref;
-    if(ref==TimesRefFlush) {
-        tref = readout.flushtime;
-    } else if(ref==TimesRefPrevFlush) {
+    // Captured seconds are POSIX, ticks are nsec.
+    // readout.ok captures validity of timestamp at start and end of interval.
+    // skip validation of timestamps in between.
+    const epicsTimeStamp * const src = len ? &readout.buf[0] : 0;
+
+    epicsTimeStamp tref = readout.flushtime;
+    if(ref==TimesRefPrevFlush) {
         tref = readout.prevflushtime;
+    } else if(ref==TimesRefEvt0 && len) {
+        tref.secPastEpoch = src[0].secPastEpoch - POSIX_TIME_AT_EPICS_EPOCH;
+        tref.nsec = EVRMRM::ticks2ns(src[0].nsec, scale);
     }
 
-    for(size_t i=0; i<len; i++) {
-        epicsTimeStamp ts = readout.buf[i];
+    // reference in ns since the POSIX epoch
+    const epicsInt64 off = (epicsInt64(tref.secPastEpoch) + POSIX_TIME_AT_EPICS_EPOCH)*1000000000
+                           + tref.nsec;
 
-        // readout.ok captures validity of timestamp at start and end of interval.
-        // skip validation of timestamps in between.
-        ts.secPastEpoch -= POSIX_TIME_AT_EPICS_EPOCH;
-        ts.nsec = epicsUInt32(ts.nsec*period);
-
-        if(i==0 && ref==TimesRefEvt0) {
-            tref = ts;
-        }
-
-        double diff = epicsTimeDiffInSeconds(&ts, &tref);
-        arr[i] = epicsInt32(diff*1e9); // ns
-    }
+    convertNS(arr, src, len, scale, off);
 
     if(prec) {
         prec->time = tref;
@@ -183,6 +318,89 @@ epicsUInt32 EVRMRMTSBuffer::getTimesRelPrevFlush(epicsInt32 *arr, epicsUInt32 co
     return getTimes(this, arr, count, TimesRefPrevFlush);
 }
 
+epicsUInt32 EVRMRMTSBuffer::getTimesRelFirst64(epicsInt64 *arr, epicsUInt32 count) const
+{
+    return getTimes(this, arr, count, TimesRefEvt0);
+}
+
+epicsUInt32 EVRMRMTSBuffer::getTimesRelFlush64(epicsInt64 *arr, epicsUInt32 count) const
+{
+    return getTimes(this, arr, count, TimesRefFlush);
+}
+
+epicsUInt32 EVRMRMTSBuffer::getTimesRelPrevFlush64(epicsInt64 *arr, epicsUInt32 count) const
+{
+    return getTimes(this, arr, count, TimesRefPrevFlush);
+}
+
+template<typename T>
+static
+epicsUInt32 readStream(const EVRMRMTSBuffer* self, T *arr, epicsUInt32 count)
+{
+    dbCommon* prec = CurrentRecord::get();
+
+    const epicsUInt64 scale = self->evr->tsTickScale();
+
+    if(!self->ringCap || !scale) {
+        if(prec)
+            recGblSetSevr(prec, READ_ALARM, INVALID_ALARM);
+        return 0u;
+    }
+
+    self->ringTickHz();
+
+    const epicsUInt64 oldest = self->ringTotal > self->ringCap ? self->ringTotal - self->ringCap : 0u;
+
+    // new readers start with the oldest entry still in the ring
+    epicsUInt64& next = self->cursors.insert(std::make_pair((const void*)prec, oldest)).first->second;
+
+    if(next < oldest) {
+        // overwritten before this reader got to them
+        self->ringLostCnt += oldest - next;
+        next = oldest;
+        if(prec)
+            recGblSetSevr(prec, READ_ALARM, MAJOR_ALARM);
+    }
+
+    const size_t len = size_t(std::min(self->ringTotal - next, epicsUInt64(count)));
+    if(!len)
+        return 0u;
+
+    // copy out in (at most) two contiguous pieces
+    const size_t slot = size_t(next % self->ringCap);
+    const size_t len1 = std::min(len, self->ringCap - slot);
+
+    // elements are relative to the first, whose time is the record timestamp
+    const epicsInt64 off = tickNS(self->ring[slot], scale);
+
+    convertNS(arr, self->ring+slot, len1, scale, off);
+    convertNS(arr+len1, self->ring, len-len1, scale, off);
+
+    next += len;
+
+    if(prec) {
+        const epicsInt64 ns = off - epicsInt64(POSIX_TIME_AT_EPICS_EPOCH)*1000000000;
+        if(ns>=0) {
+            prec->time.secPastEpoch = epicsUInt32(ns/1000000000);
+            prec->time.nsec = epicsUInt32(ns%1000000000);
+        } else {
+            recGblSetSevr(prec, READ_ALARM, INVALID_ALARM);
+        }
+    }
+
+    return len;
+}
+
+epicsUInt32 EVRMRMTSBuffer::getStream(double *arr, epicsUInt32 count) const
+{
+    return readStream(this, arr, count);
+}
+
+epicsUInt32 EVRMRMTSBuffer::getStream64(epicsInt64 *arr, epicsUInt32 count) const
+{
+    return readStream(this, arr, count);
+}
+
 static
 mrf::Object*
 buildInstance(const std::string& name, const std::string& klass, const mrf::Object::create_args_t& args)
@@ -213,9 +431,19 @@ OBJECT_BEGIN(EVRMRMTSBuffer)
     OBJECT_PROP2("FlushEvent", &EVRMRMTSBuffer::flushEvent, &EVRMRMTSBuffer::flushEventSet);
     OBJECT_PROP1("FlushManual", &EVRMRMTSBuffer::flushNow);
     OBJECT_PROP1("TimesRelFirst", &EVRMRMTSBuffer::getTimesRelFirst);
+    OBJECT_PROP1("TimesRelFirst", &EVRMRMTSBuffer::getTimesRelFirst64);
     OBJECT_PROP1("TimesRelFirst", &EVRMRMTSBuffer::flushed);
     OBJECT_PROP1("TimesRelFlush", &EVRMRMTSBuffer::getTimesRelFlush);
+    OBJECT_PROP1("TimesRelFlush", &EVRMRMTSBuffer::getTimesRelFlush64);
     OBJECT_PROP1("TimesRelFlush", &EVRMRMTSBuffer::flushed);
     OBJECT_PROP1("TimesRelPrevFlush", &EVRMRMTSBuffer::getTimesRelPrevFlush);
+    OBJECT_PROP1("TimesRelPrevFlush", &EVRMRMTSBuffer::getTimesRelPrevFlush64);
     OBJECT_PROP1("TimesRelPrevFlush", &EVRMRMTSBuffer::flushed);
+    OBJECT_PROP2("RingSize", &EVRMRMTSBuffer::ringSize, &EVRMRMTSBuffer::ringSizeSet);
+    OBJECT_PROP2("RingFile", &EVRMRMTSBuffer::ringFile, &EVRMRMTSBuffer::ringFileSet);
+    OBJECT_PROP1("RingCount", &EVRMRMTSBuffer::ringCount);
+    OBJECT_PROP1("RingLost", &EVRMRMTSBuffer::ringLost);
+    OBJECT_PROP1("Stream", &EVRMRMTSBuffer::getStream);
+    OBJECT_PROP1("Stream", &EVRMRMTSBuffer::getStream64);
+    OBJECT_PROP1("Stream", &EVRMRMTSBuffer::flushed);
 OBJECT_END(EVRMRMTSBuffer)
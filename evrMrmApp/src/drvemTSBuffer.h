@@ -7,6 +7,7 @@
 #define DRVEMTSBUFFER_H
 
 #include <vector>
+#include <map>
 #include <utility> // std::pair
 
 #include <dbScan.h>
@@ -15,6 +16,19 @@
 
 class EVRMRM;
 
+/* Layout of the optional memory mapped file backing a capture ring.
+ * The header is followed by 'capacity' entries of two epicsUInt32,
+ * POSIX seconds then TS clock ticks, in host byte order.
+ * The most recent entry is at slot (count-1)%capacity.
+ */
+struct EVRMRMTSRingHeader {
+    char magic[8];        // "MRFTSRNG"
+    epicsUInt32 version;  // 1
+    epicsUInt32 capacity; // entries
+    epicsUInt64 count;    // total entries ever written
+    double tickHz;        // TS clock, as last known
+};
+
 struct EVRMRMTSBuffer : public mrf::ObjectInst<EVRMRMTSBuffer>
 {
     typedef mrf::ObjectInst<EVRMRMTSBuffer> base_t;
@@ -39,9 +53,41 @@ struct EVRMRMTSBuffer : public mrf::ObjectInst<EVRMRMTSBuffer>
     epicsUInt32 getTimesRelFirst(epicsInt32 *arr, epicsUInt32 count) const;
     epicsUInt32 getTimesRelFlush(epicsInt32 *arr, epicsUInt32 count) const;
     epicsUInt32 getTimesRelPrevFlush(epicsInt32 *arr, epicsUInt32 count) const;
+    // same in 64-bit, which can't overflow
+    epicsUInt32 getTimesRelFirst64(epicsInt64 *arr, epicsUInt32 count) const;
+    epicsUInt32 getTimesRelFlush64(epicsInt64 *arr, epicsUInt32 count) const;
+    epicsUInt32 getTimesRelPrevFlush64(epicsInt64 *arr, epicsUInt32 count) const;
 
     IOSCANPVT flushed() const { return scan; }
 
+    /* Continuous capture ring.
+     * Every occurrence of timeEvt is appended, independent of flushing.
+     * Each reading record pulls the entries since its previous read.
+     */
+    epicsUInt32 ringSize() const { return epicsUInt32(ringCap); }
+    void ringSizeSet(epicsUInt32 n);
+    std::string ringFile() const { return ringFileName; }
+    void ringFileSet(std::string f);
+    epicsUInt32 ringCount() const { return epicsUInt32(ringTotal); }
+    epicsUInt32 ringLost() const { return epicsUInt32(ringLostCnt); }
+
+    epicsUInt32 getStream(double *arr, epicsUInt32 count) const;
+    epicsUInt32 getStream64(epicsInt64 *arr, epicsUInt32 count) const;
+
+    // caller must hold evrLock
+    void ringPush(epicsUInt32 sec, epicsUInt32 ticks)
+    {
+        if(!ringCap)
+            return;
+        ring[ringPos].secPastEpoch = sec;
+        ring[ringPos].nsec = ticks;
+        if(++ringPos==ringCap)
+            ringPos = 0u;
+        ringTotal++;
+        if(ringHdr)
+            ringHdr->count = ringTotal;
+    }
+
     EVRMRM* const evr;
 
     epicsUInt32 dropped;
@@ -68,6 +114,21 @@ struct EVRMRMTSBuffer : public mrf::ObjectInst<EVRMRMTSBuffer>
     // active buffer being filled.  Other is for readout.
     // must lock both evr and this mutex to change.
     unsigned char active; // either 0 or 1
+
+    epicsTimeStamp *ring; // ringmem or file mapping
+    size_t ringCap, ringPos;
+    epicsUInt64 ringTotal;
+    mutable epicsUInt64 ringLostCnt;
+    std::vector<epicsTimeStamp> ringmem;
+    std::string ringFileName;
+    EVRMRMTSRingHeader *ringHdr; // non-NULL when file backed
+    size_t ringMapLen;
+    // next entry to be read by each record
+    typedef std::map<const void*, epicsUInt64> cursors_t;
+    mutable cursors_t cursors;
+
+    void ringFree();
+    void ringTickHz() const;
 };
 
 #endif // DRVEMTSBUFFER_H
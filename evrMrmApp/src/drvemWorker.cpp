@@ -0,0 +1,105 @@
+/*************************************************************************\
+* mrfioc2 is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+#include <stdexcept>
+
+#include <errlog.h>
+#include <dbScan.h>
+#include <callback.h>
+
+#include "drvem.h"
+#include "drvemWorker.h"
+
+/* scanIoImmediate() processes a scan list in the calling thread */
+#if EPICS_VERSION_INT>=VERSION_INT(3,16,1,0)
+#  define HAVE_SCAN_IMMEDIATE
+#endif
+
+bool EVRMRMWorker::supported()
+{
+#ifdef HAVE_SCAN_IMMEDIATE
+    return true;
+#else
+    return false;
+#endif
+}
+
+EVRMRMWorker::EVRMRMWorker(EVRMRM& evr, const std::string& name, unsigned int prio, int cpu)
+    :evr(evr)
+    ,wname(name)
+    ,cpuSel(cpu)
+    ,stopping(false)
+    ,count_processed(0)
+    ,count_dropped(0)
+    ,worker(*this, name.c_str(),
+            epicsThreadGetStackSize(epicsThreadStackBig),
+            prio)
+{
+    if(!supported())
+        throw std::runtime_error("Event worker threads require Base >= 3.16.1");
+    if(prio>epicsThreadPriorityMax)
+        throw std::out_of_range("Invalid thread priority");
+    worker.start();
+}
+
+EVRMRMWorker::~EVRMRMWorker()
+{
+    stop();
+}
+
+void EVRMRMWorker::stop()
+{
+    {
+        SCOPED_LOCK(stopLock);
+        stopping = true;
+    }
+    wakeup.signal();
+    worker.exitWait();
+}
+
+bool EVRMRMWorker::queue(eventCode *evt)
+{
+    if(!pending.push(evt)) {
+        count_dropped++;
+        return false;
+    }
+    wakeup.signal();
+    return true;
+}
+
+void EVRMRMWorker::run()
+{
+    if(cpuSel>=0 && !mrfSetThreadCPU(cpuSel))
+        errlogPrintf("%s: unable to bind to CPU %d\n", wname.c_str(), cpuSel);
+
+    eventCode *evt;
+
+    while(true) {
+        wakeup.wait();
+
+        {
+            SCOPED_LOCK(stopLock);
+            if(stopping)
+                break;
+        }
+
+        while(pending.pop(evt)) {
+#ifdef HAVE_SCAN_IMMEDIATE
+            // highest priority first
+            for(int p=NUM_CALLBACK_PRIORITIES-1; p>=0; p--)
+                scanIoImmediate(evt->occured, p);
+#endif
+            count_processed++;
+
+            try {
+                SCOPED_LOCK2(evr.evrLock, guard);
+                EVRMRM::eventComplete(evt);
+            } catch(std::exception& e) {
+                errlogPrintf("%s: exception completing event %u: %s\n",
+                             wname.c_str(), (unsigned)evt->code, e.what());
+            }
+        }
+    }
+}
@@ -0,0 +1,70 @@
+/*************************************************************************\
+* mrfioc2 is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+#ifndef DRVEMWORKER_H
+#define DRVEMWORKER_H
+
+#include <string>
+
+#include <epicsThread.h>
+#include <epicsEvent.h>
+#include <epicsMutex.h>
+
+#include "mrf/spscring.h"
+
+class EVRMRM;
+struct eventCode;
+
+/** @brief Dedicated thread for the I/O Intr scans of some event codes
+ *
+ * Event codes bound to a worker bypass the shared callback queues.
+ * The scan lists of all priorities are processed in the worker thread
+ * with scanIoImmediate() (Base >= 3.16.1).
+ * Notifiees are still called by the FIFO dispatch thread.
+ */
+class EVRMRMWorker : public epicsThreadRunable
+{
+public:
+    //! @param cpu CPU to bind to, or -1 for any
+    EVRMRMWorker(EVRMRM& evr, const std::string& name, unsigned int prio, int cpu);
+    virtual ~EVRMRMWorker();
+
+    //! Request stop and wait for the thread to exit
+    void stop();
+
+    /** Queue scans for an event.
+     * May only be called from the (single) FIFO dispatching thread
+     * with evrLock held.
+     * @returns false, and counts a drop, if the queue is full
+     */
+    bool queue(eventCode *evt);
+
+    epicsUInt32 processedCount() const { return count_processed; }
+    epicsUInt32 droppedCount() const { return count_dropped; }
+    int cpu() const { return cpuSel; }
+    const std::string& name() const { return wname; }
+
+    virtual void run() OVERRIDE FINAL;
+
+    //! Whether this Base version can run scans in a worker
+    static bool supported();
+
+private:
+    EVRMRM& evr;
+    const std::string wname;
+    const int cpuSel;
+
+    // each event code is queued at most once (cf. eventCode::waitingfor)
+    mrf::SPSCRing<eventCode*, 256> pending;
+    epicsEvent wakeup;
+    mutable epicsMutex stopLock;
+    bool stopping;
+
+    volatile epicsUInt32 count_processed;
+    volatile epicsUInt32 count_dropped;
+
+    epicsThread worker;
+};
+
+#endif // DRVEMWORKER_H
@@ -39,3 +39,13 @@ void MRMGpio::setOutput(epicsUInt32 val)
 {
     WRITE32(owner_.base, GPIOOut, val);
 }
+
+void MRMGpio::setOutput(mrf::RegBatch& batch, epicsUInt32 val)
+{
+    BATCH_WRITE32(batch, GPIOOut, val);
+}
+
+mrf::RegShadow& MRMGpio::regs()
+{
+    return owner_.shadow;
+}
@@ -11,6 +11,8 @@
 
 #include <epicsMutex.h>
 
+#include "mrf/regshadow.h"
+
 class EVRMRM;
 
 class MRMGpio{
@@ -24,6 +26,8 @@ public:
 
     epicsUInt32 getOutput(); // reads the data from the output register
     void setOutput(epicsUInt32); // writes the data to the output register
+    void setOutput(mrf::RegBatch&, epicsUInt32); // queues a write to the output register
+    mrf::RegShadow& regs(); // for batches of writes
 
     // mutex for locking access to GPIO pins.
     epicsMutex lock_;
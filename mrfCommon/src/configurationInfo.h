@@ -28,7 +28,8 @@ struct configuration_pci{
 
 enum busType{
     busType_vme = 0,
-    busType_pci = 1
+    busType_pci = 1,
+    busType_sim = 2  // simulated in host memory.  cf. mrf/simio.h
 };
 
 struct bus_configuration{
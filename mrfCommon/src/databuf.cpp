@@ -4,6 +4,12 @@
 
 OBJECT_BEGIN(dataBufRx) {
     OBJECT_PROP2("Enable", &dataBufRx::dataRxEnabled, &dataBufRx::dataRxEnable);
+    OBJECT_PROP1("Proto Count", &dataBufRx::dataRxProtoCount);
+    OBJECT_PROP1("Proto Drop", &dataBufRx::dataRxProtoDrop);
+    OBJECT_PROP1("Pool Size", &dataBufRx::dataRxPoolSize);
+    OBJECT_PROP1("Pool HWM", &dataBufRx::dataRxPoolHWM);
+    OBJECT_PROP1("Pool Drop", &dataBufRx::dataRxPoolDrop);
+    OBJECT_PROP1("Residency", &dataBufRx::dataRxResidency);
 } OBJECT_END(dataBufRx)
 
 OBJECT_BEGIN(dataBufTx) {
@@ -12,6 +18,34 @@ OBJECT_BEGIN(dataBufTx) {
     OBJECT_PROP1("Max length", &dataBufTx::lenMax);
 } OBJECT_END(dataBufTx)
 
+void dataBufTx::dataSendAsync(epicsUInt32 len, const epicsUInt8 *buf,
+                              dataBufComplete fptr, void *arg)
+{
+    dataSend(len, buf);
+    if(fptr)
+        (*fptr)(arg, 0, len, buf);
+}
+
+bool dataBufRx::dataRxRetain(const epicsUInt8 *) { return false; }
+void dataBufRx::dataRxRelease(const epicsUInt8 *) {}
+
+void dataBufRx::dataRxAddReceive(epicsUInt8, dataBufComplete fptr, void* arg)
+{
+    dataRxAddReceive(fptr, arg);
+}
+
+void dataBufRx::dataRxDeleteReceive(epicsUInt8, dataBufComplete fptr, void* arg)
+{
+    dataRxDeleteReceive(fptr, arg);
+}
+
+epicsUInt32 dataBufRx::dataRxProtoCount(epicsUInt32 *, epicsUInt32) const { return 0; }
+epicsUInt32 dataBufRx::dataRxProtoDrop(epicsUInt32 *, epicsUInt32) const { return 0; }
+epicsUInt32 dataBufRx::dataRxPoolSize() const { return 0; }
+epicsUInt32 dataBufRx::dataRxPoolHWM() const { return 0; }
+epicsUInt32 dataBufRx::dataRxPoolDrop() const { return 0; }
+double dataBufRx::dataRxResidency() const { return 0.0; }
+
 // definition for pure virtual is required in most cases (apparently not MSVC w/ static linking?)
 // If bottom 2 lines are removed, MSVC does not report warning C4273
 #if !defined(_WIN32) || (defined(_WIN32) && defined(_DLL))
@@ -95,7 +95,8 @@ linkOptionEnumType readbackEnum[];
 
 template<typename T>
 struct addr : public addrBase {
-    mrf::auto_ptr<mrf::property<T> > P;
+    //! owned by O
+    mrf::property<T> *P;
 };
 
 epicsShareExtern const
@@ -177,15 +178,15 @@ try {
         return S_db_errArg;
     }
 
-    mrf::auto_ptr<property<P> > prop = o->getProperty<P>(a->prop);
-    if(!prop.get()) {
+    property<P> *prop = o->findProperty<P>(a->prop);
+    if(!prop) {
         errlogPrintf("%s: '%s' lacks property '%s' of required type %s\n",
                      prec->name, o->name().c_str(), a->prop, typeid(P).name());
         return S_db_errArg;
     }
 
     a->O = o;
-    a->P = PTRMOVE(prop);
+    a->P = prop;
 
     prec->dpvt = (void*)a.release();
 
@@ -243,9 +244,9 @@ if (!prec->dpvt) {(void)recGblSetSevr(prec, COMM_ALARM, INVALID_ALARM); return -
 try {
     addrBase *prop=static_cast<addrBase*>(prec->dpvt);
 
-    mrf::auto_ptr<property<IOSCANPVT> > up = prop->O->getProperty<IOSCANPVT>(prop->prop);
+    property<IOSCANPVT> *up = prop->O->findProperty<IOSCANPVT>(prop->prop);
 
-    if(up.get()) {
+    if(up) {
         *io = up->get();
     } else {
         errlogPrintf("%s Warning: I/O Intr not supported by PROP=%s\n", prec->name, prop->prop);
@@ -15,6 +15,10 @@
 
 #include "devObj.h"
 
+#if EPICS_VERSION_INT>=VERSION_INT(3,16,1,0)
+#  define MRF_WF_INT64
+#endif
+
 using namespace mrf;
 
 static inline
@@ -34,6 +38,12 @@ long add_record_waveform(dbCommon *pcom)
         return add_record_property<epicsInt32[1]>(pcom, &prec->inp);
     case menuFtypeULONG:
         return add_record_property<epicsUInt32[1]>(pcom, &prec->inp);
+#ifdef MRF_WF_INT64
+    case menuFtypeINT64:
+        return add_record_property<epicsInt64[1]>(pcom, &prec->inp);
+    case menuFtypeUINT64:
+        return add_record_property<epicsUInt64[1]>(pcom, &prec->inp);
+#endif
     case menuFtypeFLOAT:
         return add_record_property<float[1]>(pcom, &prec->inp);
     case menuFtypeDOUBLE:
@@ -72,6 +82,12 @@ try {
         readop<epicsInt32>(prec); break;
     case menuFtypeULONG:
         readop<epicsUInt32>(prec); break;
+#ifdef MRF_WF_INT64
+    case menuFtypeINT64:
+        readop<epicsInt64>(prec); break;
+    case menuFtypeUINT64:
+        readop<epicsUInt64>(prec); break;
+#endif
     case menuFtypeFLOAT:
         readop<float>(prec); break;
     case menuFtypeDOUBLE:
@@ -121,6 +137,12 @@ try {
         writeop<epicsInt32>(prec); break;
     case menuFtypeULONG:
         writeop<epicsUInt32>(prec); break;
+#ifdef MRF_WF_INT64
+    case menuFtypeINT64:
+        writeop<epicsInt64>(prec); break;
+    case menuFtypeUINT64:
+        writeop<epicsUInt64>(prec); break;
+#endif
     case menuFtypeFLOAT:
         writeop<float>(prec); break;
     case menuFtypeDOUBLE:
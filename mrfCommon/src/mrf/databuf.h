@@ -17,6 +17,8 @@
 #ifndef DATABUF_H_INC
 #define DATABUF_H_INC
 
+#include <algorithm>
+
 #include <epicsTypes.h>
 #include <epicsTime.h>
 
@@ -55,6 +57,22 @@ public:
      */
     virtual void dataSend(epicsUInt32 len, const epicsUInt8 *buf)=0;
 
+    /**@brief Queue a byte array for transmission
+     *
+     * 'buf' is copied before this returns.  'fptr' is later called,
+     * possibly from another thread, with 'ok' zero once the buffer is sent,
+     * or non-zero if it could not be sent (1 - queue full, 2 - timeout).
+     * The 'buf' passed to 'fptr' is the pointer given here.
+     *
+     * The default implementation calls dataSend() then 'fptr'.
+     *
+     *@param len Number of bytes to send
+     *@param buf[in] Pointer to byte array to be sent
+     *@param fptr[in] Completion function.  May be NULL
+     *@param arg[in] Arbitrary pointer passed to completion function
+     */
+    virtual void dataSendAsync(epicsUInt32 len, const epicsUInt8 *buf,
+                               dataBufComplete fptr, void *arg=0);
 };
 
 
@@ -88,6 +106,112 @@ public:
     /**@brief Unregister
      */
     virtual void dataRxDeleteReceive(dataBufComplete fptr, void* arg=0)=0;
+
+    /**@brief Register to receive data buffers with one Protocol ID
+     *
+     * Only buffers whose first byte is 'proto' are passed to 'fptr'.
+     * The default implementation registers for all buffers,
+     * so 'fptr' must still check the Protocol ID.
+     *
+     *@param proto Protocol ID
+     *@param fptr[in] Function pointer invoken after Rx
+     *@param arg[in] Arbitrary pointer passed to completion function
+     */
+    virtual void dataRxAddReceive(epicsUInt8 proto, dataBufComplete fptr, void* arg=0);
+
+    /**@brief Unregister.  'proto' must match dataRxAddReceive()
+     */
+    virtual void dataRxDeleteReceive(epicsUInt8 proto, dataBufComplete fptr, void* arg=0);
+
+    /**@brief Per Protocol ID counters
+     *
+     * Element N of each array is for Protocol ID N.
+     * Buffers dropped are those received with no listener.
+     */
+    virtual epicsUInt32 dataRxProtoCount(epicsUInt32 *arr, epicsUInt32 count) const;
+    virtual epicsUInt32 dataRxProtoDrop(epicsUInt32 *arr, epicsUInt32 count) const;
+
+    //! Number of Rx buffers currently allocated
+    virtual epicsUInt32 dataRxPoolSize() const;
+    //! Most Rx buffers in use at one time
+    virtual epicsUInt32 dataRxPoolHWM() const;
+    //! Buffers lost because no free Rx buffer was available
+    virtual epicsUInt32 dataRxPoolDrop() const;
+    //! Average time (sec.) from reception until a buffer is free again
+    virtual double dataRxResidency() const;
+
+    /**@brief Keep a received buffer after the completion function returns
+     *
+     * May only be called from within a dataBufComplete function,
+     * with the 'buf' it was passed, or while another retained reference
+     * to 'buf' is held.  'buf' then remains valid, and unchanged,
+     * until a matching call to dataRxRelease(), which may be made from any thread.
+     *
+     *@returns false if not supported.  The caller must then copy 'buf'.
+     */
+    virtual bool dataRxRetain(const epicsUInt8 *buf);
+
+    /**@brief Return a buffer kept with dataRxRetain()
+     */
+    virtual void dataRxRelease(const epicsUInt8 *buf);
+};
+
+/**@brief Counted reference to a received buffer
+ *
+ * Construct from within a dataBufComplete function to keep the buffer
+ * for later use without copying.  The buffer is returned to its
+ * owner when the last copy of the reference is destroyed or reset().
+ *
+ * If the receiver can't retain buffers then data() is NULL.
+ */
+class dataBufRxRef {
+    dataBufRx *rx;
+    const epicsUInt8 *buf;
+    epicsUInt32 len;
+public:
+    dataBufRxRef() :rx(0), buf(0), len(0) {}
+    dataBufRxRef(dataBufRx *rx, epicsUInt32 len, const epicsUInt8 *buf)
+        :rx(rx), buf(buf), len(len)
+    {
+        if(!rx || !buf || !rx->dataRxRetain(buf)) {
+            this->rx = 0;
+            this->buf = 0;
+            this->len = 0;
+        }
+    }
+    dataBufRxRef(const dataBufRxRef& o)
+        :rx(o.rx), buf(o.buf), len(o.len)
+    {
+        if(buf)
+            rx->dataRxRetain(buf);
+    }
+    ~dataBufRxRef() { reset(); }
+
+    dataBufRxRef& operator=(const dataBufRxRef& o)
+    {
+        dataBufRxRef temp(o);
+        swap(temp);
+        return *this;
+    }
+
+    void swap(dataBufRxRef& o)
+    {
+        std::swap(rx, o.rx);
+        std::swap(buf, o.buf);
+        std::swap(len, o.len);
+    }
+
+    void reset()
+    {
+        if(buf)
+            rx->dataRxRelease(buf);
+        rx = 0;
+        buf = 0;
+        len = 0;
+    }
+
+    const epicsUInt8* data() const { return buf; }
+    epicsUInt32 size() const { return len; }
 };
 
 #endif // DATABUF_H_INC
@@ -35,7 +35,9 @@
  @internal
  *
  * Properties are stored unbound (not associated with an instance).
- * Currently a new bound property is allocated for each request.
+ * getProperty() allocates a new bound property for each request.
+ * findProperty() and visitProperties() use properties bound once
+ * per instance, on first use, and owned by the instance.
  */
 #ifndef MRFOBJECT_H
 #define MRFOBJECT_H
@@ -74,6 +76,7 @@
 #include <sstream>
 #include <map>
 #include <set>
+#include <vector>
 #include <cstring>
 #include <string>
 #include <memory>
@@ -82,6 +85,7 @@
 
 #include <compilerDependencies.h>
 #include <epicsThread.h>
+#include <epicsMutex.h>
 #include <epicsTypes.h>
 
 #ifndef EPICS_UNUSED
@@ -175,6 +179,11 @@ struct property<void> : public propertyBase
 
 namespace detail {
 
+//! Order property names without constructing std::string
+struct cstrLess {
+    bool operator()(const char* a, const char* b) const { return strcmp(a, b)<0; }
+};
+
 /** @brief An un-typed, un-bound property for class C
  *
  * This is the form in which properties are stored
@@ -183,6 +192,10 @@ namespace detail {
 template<class C>
 struct unboundPropertyBase
 {
+    //! Position in the property table of C.  Set by OBJECT_END
+    size_t index;
+
+    unboundPropertyBase() :index(0) {}
     virtual ~unboundPropertyBase(){};
     virtual const std::type_info& type() const=0;
 
@@ -413,8 +426,25 @@ public:
         return mrf::auto_ptr<property<P> >(p);
     }
 
+    /** @brief Lookup a property without allocating
+     *
+     * The returned property is owned by this Object and must not be deleted.
+     * Returns NULL if not found.
+     */
+    virtual propertyBase* findPropertyBase(const char*, const std::type_info&);
+    template<typename P>
+    property<P>* findProperty(const char* pname)
+    {
+        return dynamic_cast<property<P>*>(findPropertyBase(pname, typeid(P)));
+    }
+
     virtual void visitProperties(bool (*)(propertyBase*, void*), void*)=0;
 
+protected:
+    //! Guards the bound property cache of every Object
+    static epicsMutex& propertyCacheLock();
+public:
+
     //! Fetch named Object
     //! returns NULL if not found
     static Object* getObject(const std::string& name);
@@ -458,15 +488,34 @@ public:
 template<class C, typename Base = Object>
 class epicsShareClass ObjectInst : public Base
 {
-    typedef std::multimap<std::string, detail::unboundPropertyBase<C>*> m_props_t;
+    typedef std::multimap<const char*, detail::unboundPropertyBase<C>*, detail::cstrLess> m_props_t;
     static m_props_t *m_props;
+
+    //! Bound properties of this instance, indexed by unboundPropertyBase::index.
+    //! Guarded by propertyCacheLock().  Entries are never replaced once set.
+    std::vector<propertyBase*> m_bound;
+
+    // Caller must hold propertyCacheLock()
+    propertyBase* bound(detail::unboundPropertyBase<C>* u)
+    {
+        if(m_bound.size()!=m_props->size())
+            m_bound.resize(m_props->size(), 0);
+        propertyBase *&b = m_bound[u->index];
+        if(!b)
+            b = u->bind(static_cast<C*>(this));
+        return b;
+    }
 public:
     static int initObject();
 protected:
     explicit ObjectInst(const std::string& n) : Base(n) {}
     template<typename A>
     ObjectInst(const std::string& n, A& a) : Base(n, a) {}
-    virtual ~ObjectInst(){}
+    virtual ~ObjectInst()
+    {
+        for(size_t i=0; i<m_bound.size(); i++)
+            delete m_bound[i];
+    }
 public:
 
     virtual propertyBase* getPropertyBase(const char* pname, const std::type_info& ptype)
@@ -474,30 +523,53 @@ public:
         std::string emsg;
         if(!m_props)
             throw std::runtime_error(emsg);
-        typename m_props_t::const_iterator it=m_props->lower_bound(pname),
-                                          end=m_props->upper_bound(pname);
-        for(;it!=end;++it) {
-            if(it->second->type()==ptype)
-                return it->second->bind(static_cast<C*>(this));
+        std::pair<typename m_props_t::const_iterator, typename m_props_t::const_iterator>
+                range = m_props->equal_range(pname);
+        for(;range.first!=range.second;++range.first) {
+            if(range.first->second->type()==ptype)
+                return range.first->second->bind(static_cast<C*>(this));
         }
         // continue checking for Base class properties
         return Base::getPropertyBase(pname, ptype);
     }
 
+    virtual propertyBase* findPropertyBase(const char* pname, const std::type_info& ptype)
+    {
+        std::string emsg;
+        if(!m_props)
+            throw std::runtime_error(emsg);
+        {
+            SCOPED_LOCK2(Object::propertyCacheLock(), G);
+            std::pair<typename m_props_t::const_iterator, typename m_props_t::const_iterator>
+                    range = m_props->equal_range(pname);
+            for(;range.first!=range.second;++range.first) {
+                if(range.first->second->type()==ptype)
+                    return bound(range.first->second);
+            }
+        }
+        // continue checking for Base class properties
+        return Base::findPropertyBase(pname, ptype);
+    }
+
     virtual void visitProperties(bool (*cb)(propertyBase*, void*), void* arg)
     {
         std::string emsg;
         if(!m_props)
             throw std::runtime_error(emsg);
 
-        mrf::auto_ptr<propertyBase> cur;
-        for(typename m_props_t::const_iterator it=m_props->begin();
-            it!=m_props->end(); ++it)
         {
-            cur.reset(it->second->bind(static_cast<C*>(this)));
-            if(!cur.get())
+            SCOPED_LOCK2(Object::propertyCacheLock(), G);
+            for(typename m_props_t::const_iterator it=m_props->begin();
+                it!=m_props->end(); ++it)
+                bound(it->second);
+        }
+
+        // callbacks made without propertyCacheLock.  m_bound no longer changes
+        for(size_t i=0; i<m_bound.size(); i++)
+        {
+            if(!m_bound[i])
                 continue;
-            if(!(*cb)(cur.get(), arg))
+            if(!(*cb)(m_bound[i], arg))
                 break;
         }
         Base::visitProperties(cb, arg);
@@ -521,7 +593,9 @@ template<> int ObjectInst<klass, Base>::initObject() { \
 #define OBJECT_FACTORY(FN) addFactory(klassname, FN)
 
 #define OBJECT_END(klass) \
-} m_props = props.release(); return 1; \
+} { size_t idx=0; \
+    for(m_props_t::iterator it=props->begin(); it!=props->end(); ++it) it->second->index = idx++; } \
+  m_props = props.release(); return 1; \
 } catch(std::exception& e) { \
 std::cerr<<"Failed to build property table for "<<typeid(klass).name()<<"\n"<<e.what()<<"\n"; \
 throw std::runtime_error("Failed to build"); \
@@ -4,29 +4,60 @@
 #include <epicsThread.h>
 #include <epicsEvent.h>
 #include <epicsMutex.h>
+#include <epicsTime.h>
+#include <epicsTypes.h>
 #include <shareLib.h>
 
 extern "C" {
     typedef void (*pollerFN)(void *);
+
+    /* Used by PCI cards set up afterwards.
+     * mrfIRQPoll!=0 polls the card from a thread instead of using its interrupt.
+     * See IRQPoller for mrfIRQPollPeriod and mrfIRQPollCPU.
+     */
+    epicsShareExtern int mrfIRQPoll;
+    epicsShareExtern double mrfIRQPollPeriod;
+    epicsShareExtern int mrfIRQPollCPU;
 }
 
+/** @brief Call an ISR from a thread
+ *
+ * For hosts where the card interrupt can't be used.
+ *
+ * With period>0, sleep this long (seconds) between calls.
+ * Latency is then limited by the OS timer resolution.
+ * With period==0, busy-poll.  This uses all of one CPU,
+ * so should be pinned (cpu>=0, Linux only) to an otherwise idle core.
+ */
 class epicsShareClass IRQPoller : protected epicsThreadRunable {
 
     epicsEvent evt;
-    epicsMutex lock;
-    bool done;
+    mutable epicsMutex lock;
+    volatile bool done;
     const double period;
+    const int cpu;
 
     const pollerFN fn;
     void * const arg;
 
+    // written by run() under lock, once for each batch of calls
+    volatile epicsUInt32 count;
+    double meanLoop;
+
     epicsThread runner;
 
     virtual void run();
 public:
-    IRQPoller(pollerFN fn, void *arg, double period);
+    IRQPoller(pollerFN fn, void *arg, double period,
+              int cpu=-1, const char *name="IRQPoller");
     virtual ~IRQPoller();
 
+    double pollPeriod() const {return period;}
+    //! Number of calls made.  Updated after each batch of calls
+    epicsUInt32 pollCount() const {return count;}
+    //! Mean time (seconds) of one loop over the last batch of calls
+    double loopTime() const;
+
 private:
     IRQPoller(const IRQPoller&);
     IRQPoller& operator=(const IRQPoller&);
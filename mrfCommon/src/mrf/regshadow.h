@@ -0,0 +1,159 @@
+/*************************************************************************\
+* mrfioc2 is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+#ifndef MRF_REGSHADOW_H
+#define MRF_REGSHADOW_H
+
+#include <stddef.h>
+
+#include <string>
+#include <vector>
+
+#include <epicsTypes.h>
+#include <epicsMutex.h>
+#include <shareLib.h>
+
+namespace mrf {
+
+/** @brief Host copy of configuration registers which only this driver changes
+ *
+ * Reads of registers marked with cache() are served from host memory.
+ * Writes go to both the card and the copy.  Other registers, including
+ * all status registers, are passed through to the card.
+ *
+ * The set of cached registers is fixed by cache() calls during setup,
+ * before any concurrent access.  Afterwards callers serialize access to
+ * each register as they would without the shadow.
+ *
+ * Divergence (eg. after a card reset) is found with verify(),
+ * which may also scrub the card by re-writing the cached values.
+ * The IOC shell command mrfShadowVerify() does this by name.
+ */
+class epicsShareClass RegShadow
+{
+    volatile epicsUInt8 * const base;
+    const epicsUInt32 len;
+    const std::string name;
+    epicsMutex& devlock;
+
+    // sized to cover the highest cached register
+    std::vector<epicsUInt32> image;
+    // bits which the card may change, ignored by verify()
+    std::vector<epicsUInt32> ignore;
+    std::vector<bool> valid;
+
+    RegShadow(const RegShadow&);
+    RegShadow& operator=(const RegShadow&);
+public:
+    /**
+     @param name Used to find this shadow with mrfShadowVerify()
+     @param base Register map
+     @param len Size of register map in bytes
+     @param devlock Held by verify().  Serializes access to the registers.
+     */
+    RegShadow(const std::string& name, volatile epicsUInt8 *base,
+              epicsUInt32 len, epicsMutex& devlock);
+    ~RegShadow();
+
+    /** Cache len bytes of 32-bit registers starting from offset.
+     * Loads the current values from the card.
+     @param live Bits of these registers which the card may change.
+                 Reads return these as last written.
+     */
+    void cache(epicsUInt32 offset, epicsUInt32 len=4, epicsUInt32 live=0);
+
+    bool cached(epicsUInt32 offset) const
+    { return offset/4u<valid.size() && valid[offset/4u]; }
+
+    size_t ncached() const;
+
+    epicsUInt32 read32(epicsUInt32 offset) const;
+    void write32(epicsUInt32 offset, epicsUInt32 val);
+
+    //! Read from the card and update the copy.
+    //! For write-then-readback tests of optional firmware features.
+    epicsUInt32 reload32(epicsUInt32 offset);
+
+    /** Compare the copy with the card.  Caller must hold devlock.
+     @param scrub If true, re-write differing registers from the copy
+     @param verbose Print differences
+     @returns The number of registers which differ
+     */
+    size_t verify(bool scrub, bool verbose=true);
+
+    //! Find by name and verify() with devlock held.
+    //! @returns The number of registers which differ, or -1 if not found
+    static long verifyByName(const std::string& name, bool scrub);
+
+    //! A read with no side effects, to wait for preceding writes to complete.
+    void barrier(epicsUInt32 offset) const;
+};
+
+/** @brief A sequence of register writes performed together
+ *
+ * Writes are queued in host memory, then performed in order by flush(),
+ * followed by a single read-back to ensure that all have completed.
+ * Unflushed writes are performed on destruction.
+ *
+ * Each write32() is performed, including repeated writes to one register
+ * (eg. bit-banging a GPIO).  update32() replaces an unflushed write to
+ * the same register.
+ *
+ * The caller must hold whatever lock guards the registers written
+ * from the first write until flush().
+ */
+class epicsShareClass RegBatch
+{
+    RegShadow& shadow;
+    const epicsUInt32 barrierReg;
+    struct op_t {
+        epicsUInt32 offset, val;
+    };
+    std::vector<op_t> ops;
+
+    RegBatch(const RegBatch&);
+    RegBatch& operator=(const RegBatch&);
+public:
+    /**
+     @param shadow Register access through this shadow
+     @param barrierReg Read after writing.  Must not have side effects.
+                       Offset 0 is the status register of all MRM cards.
+     @param reserve Expected number of writes
+     */
+    explicit RegBatch(RegShadow& shadow, epicsUInt32 barrierReg=0, size_t reserve=0);
+    ~RegBatch();
+
+    void write32(epicsUInt32 offset, epicsUInt32 val);
+    void update32(epicsUInt32 offset, epicsUInt32 val);
+
+    //! Value of the last unflushed write, or current register value
+    epicsUInt32 read32(epicsUInt32 offset) const;
+
+    size_t pending() const { return ops.size(); }
+
+    void flush();
+};
+
+} // namespace mrf
+
+/* Analogs of the READ32() etc. macros of mrfCommonIO.h which go through
+ * a RegShadow.
+ */
+#define SHADOW_READ32(shadow,offset) \
+        (shadow).read32(U32_ ## offset)
+#define SHADOW_WRITE32(shadow,offset,value) \
+        (shadow).write32(U32_ ## offset, value)
+#define SHADOW_BITSET32(shadow,offset,mask) \
+        SHADOW_WRITE32(shadow, offset, SHADOW_READ32(shadow, offset) | (epicsUInt32)(mask))
+#define SHADOW_BITCLR32(shadow,offset,mask) \
+        SHADOW_WRITE32(shadow, offset, SHADOW_READ32(shadow, offset) & ~(epicsUInt32)(mask))
+#define SHADOW_RELOAD32(shadow,offset) \
+        (shadow).reload32(U32_ ## offset)
+
+#define BATCH_WRITE32(batch,offset,value) \
+        (batch).write32(U32_ ## offset, value)
+#define BATCH_UPDATE32(batch,offset,value) \
+        (batch).update32(U32_ ## offset, value)
+
+#endif // MRF_REGSHADOW_H
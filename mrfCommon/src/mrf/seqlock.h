@@ -0,0 +1,89 @@
+/*************************************************************************\
+* mrfioc2 is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+#ifndef MRF_SEQLOCK_H
+#define MRF_SEQLOCK_H
+
+#include <stddef.h>
+
+#include <epicsVersion.h>
+#include <epicsMutex.h>
+
+#include "mrfCommon.h"
+
+#if EPICS_VERSION_INT>=VERSION_INT(3,15,0,2)
+#  include <epicsAtomic.h>
+#  define MRF_SEQLOCK_ATOMIC
+#endif
+
+namespace mrf {
+
+/** @brief A small value published by one writer to lock-free readers.
+ *
+ * Writers must be serialized by the caller (eg. by holding a device lock).
+ * tryLoad() copies the value if no store() overlapped the copy.
+ * It gives up after a bounded number of attempts so that a reader
+ * which has preempted the writer does not spin forever.
+ * The caller should then fall back to loadExcl() while holding
+ * whatever lock serializes writers.
+ *
+ * With Base < 3.15 (no epicsAtomic.h) tryLoad() always fails.
+ *
+ * T must be copyable with assignment and no side effects (POD).
+ */
+template<typename T>
+class SeqLocked
+{
+    // odd while a store() is in progress
+    size_t seq;
+    T val;
+
+    SeqLocked(const SeqLocked&);
+    SeqLocked& operator=(const SeqLocked&);
+public:
+    SeqLocked() :seq(0u), val() {}
+
+    //! Writer side.  Caller serializes writers.
+    void store(const T& v)
+    {
+#ifdef MRF_SEQLOCK_ATOMIC
+        const size_t S = seq; // we are the only writer
+        epicsAtomicSetSizeT(&seq, S+1);
+        epicsAtomicWriteMemoryBarrier();
+        val = v;
+        epicsAtomicWriteMemoryBarrier();
+        epicsAtomicSetSizeT(&seq, S+2);
+#else
+        val = v;
+#endif
+    }
+
+    //! Reader side.  Lock-free.  returns false if unable to get a consistent copy.
+    bool tryLoad(T& out, unsigned attempts=16) const
+    {
+#ifdef MRF_SEQLOCK_ATOMIC
+        for(unsigned i=0; i<attempts; i++) {
+            const size_t S = epicsAtomicGetSizeT(&seq);
+            if(S&1u)
+                continue; // store() in progress
+            epicsAtomicReadMemoryBarrier();
+            out = val;
+            epicsAtomicReadMemoryBarrier();
+            if(epicsAtomicGetSizeT(&seq)==S)
+                return true;
+        }
+#else
+        (void)out;
+        (void)attempts;
+#endif
+        return false;
+    }
+
+    //! Read while writers are excluded (by the caller)
+    T loadExcl() const { return val; }
+};
+
+} // namespace mrf
+
+#endif // MRF_SEQLOCK_H
@@ -0,0 +1,58 @@
+/*************************************************************************\
+* mrfioc2 is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+#ifndef MRF_SETUPQUEUE_H
+#define MRF_SETUPQUEUE_H
+
+#include <string>
+
+#include <shareLib.h>
+
+namespace mrf {
+
+/** @brief The slow part of one card's setup.
+ *
+ * Created by mrm*Setup*() after bus probing and register mapping.
+ * run() constructs the device object and connects its ISR.
+ */
+class epicsShareClass SetupJob
+{
+public:
+    //! Card ID, as passed to the setup function
+    const std::string name;
+
+    explicit SetupJob(const std::string& name) :name(name) {}
+    virtual ~SetupJob() {}
+
+    //! @throws std::exception on failure
+    virtual void run() =0;
+
+private:
+    SetupJob(const SetupJob&);
+    SetupJob& operator=(const SetupJob&);
+};
+
+/** @brief Concurrent card initialization before iocInit()
+ *
+ * With the IOC shell variable mrfSetupThreads==0 (the default)
+ * submit() runs each job immediately.
+ *
+ * With mrfSetupThreads>0 submit() only queues.  Queued jobs are run
+ * by that many worker threads, and waited for, either by an explicit
+ * mrfSetupWait() or at the beginning of iocInit().  A per card timing
+ * report is printed when all have completed.
+ * Cards are not usable by other IOC shell commands until then.
+ */
+struct epicsShareClass SetupQueue
+{
+    //! Run or queue.  Takes ownership of job.
+    //! @throws std::runtime_error if a job with the same name is already queued
+    static void submit(SetupJob *job);
+    //! Run all queued jobs and wait for them to complete.
+    static void wait();
+};
+
+} // namespace mrf
+
+#endif // MRF_SETUPQUEUE_H
@@ -0,0 +1,45 @@
+/*************************************************************************\
+* mrfioc2 is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+#ifndef MRF_SIMIO_H
+#define MRF_SIMIO_H
+
+/* Register access hooks for simulated devices.
+ *
+ * When built with MRF_SIM_IO defined (MRF_SIM_IO=YES in CONFIG_SITE.local)
+ * the native order and 8 bit access functions of epicsMMIO.h are
+ * replaced in mrfCommonIO.h by wrappers which first offer each access
+ * within a registered region to its handler.  A handler returns non-zero if it has completed
+ * the access, or 0 to fall through to an ordinary memory access.
+ *
+ * Regions must be registered before use, and are never removed.
+ */
+
+#include <epicsTypes.h>
+#include <shareLib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* offset from region base.  width is 8, 16, or 32.
+ * For a read, the handler stores the result through val.
+ */
+typedef int (*mrfSimIOFn)(void *pvt, epicsUInt32 offset, unsigned width,
+                          int write, epicsUInt32 *val);
+
+/* number of registered regions */
+epicsShareExtern int mrfSimIOActive;
+
+epicsShareFunc void mrfSimIORegister(volatile void *base, epicsUInt32 len,
+                                     mrfSimIOFn fn, void *pvt);
+
+epicsShareFunc int mrfSimIOAccess(volatile void *addr, unsigned width,
+                                  int write, epicsUInt32 *val);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MRF_SIMIO_H */
@@ -0,0 +1,112 @@
+/*************************************************************************\
+* mrfioc2 is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+#ifndef MRF_SPSCRING_H
+#define MRF_SPSCRING_H
+
+#include <stddef.h>
+
+#include <epicsVersion.h>
+#include <epicsAssert.h>
+#include <epicsMutex.h>
+
+#include "mrfCommon.h"
+
+#if EPICS_VERSION_INT>=VERSION_INT(3,15,0,2)
+#  include <epicsAtomic.h>
+#  define MRF_SPSC_ATOMIC
+#endif
+
+namespace mrf {
+
+/** @brief Bounded single producer, single consumer queue.
+ *
+ * push() may only be called from one thread, and pop() from one
+ * (other) thread.  Neither blocks, and neither takes a lock
+ * when epicsAtomic.h is available (Base >= 3.15).
+ * With older Base a short lived mutex guards only the index update.
+ *
+ * N must be a power of 2.
+ */
+template<typename T, size_t N>
+class SPSCRing
+{
+    // Only the producer writes 'head', and only the consumer writes 'tail'.
+    // Free running counters.  Slot is counter%N
+    size_t head, tail;
+    T buf[N];
+#ifndef MRF_SPSC_ATOMIC
+    mutable epicsMutex idxLock;
+#endif
+
+    size_t load(const size_t& idx) const
+    {
+#ifdef MRF_SPSC_ATOMIC
+        return epicsAtomicGetSizeT(&idx);
+#else
+        SCOPED_LOCK(idxLock);
+        return idx;
+#endif
+    }
+    void store(size_t& idx, size_t val)
+    {
+#ifdef MRF_SPSC_ATOMIC
+        epicsAtomicSetSizeT(&idx, val);
+#else
+        SCOPED_LOCK(idxLock);
+        idx = val;
+#endif
+    }
+
+    SPSCRing(const SPSCRing&);
+    SPSCRing& operator=(const SPSCRing&);
+public:
+    SPSCRing() :head(0u), tail(0u) {
+        STATIC_ASSERT(N>0 && (N&(N-1))==0);
+    }
+
+    size_t capacity() const { return N; }
+    //! Snapshot of the number of entries waiting.  Either side may call.
+    size_t size() const { return load(head)-load(tail); }
+
+    //! Producer side.  returns false if full
+    bool push(const T& v)
+    {
+        const size_t H = head; // we are the only writer
+        if(H - load(tail) >= N)
+            return false;
+        buf[H%N] = v;
+#ifdef MRF_SPSC_ATOMIC
+        // entry must be visible before the index which publishes it
+        epicsAtomicWriteMemoryBarrier();
+#endif
+        store(head, H+1);
+        return true;
+    }
+
+    //! Consumer side.  returns false if empty
+    bool pop(T& v)
+    {
+        const size_t T0 = tail; // we are the only writer
+        if(load(head) == T0)
+            return false;
+#ifdef MRF_SPSC_ATOMIC
+        epicsAtomicReadMemoryBarrier();
+#endif
+        v = buf[T0%N];
+#ifdef MRF_SPSC_ATOMIC
+        // Finish reading the entry before the producer may reuse it.
+        // This orders a load before a store, which needs a full barrier.
+        // The atomic increment of epicsAtomic.h is one.
+        epicsAtomicIncrSizeT(&tail);
+#else
+        store(tail, T0+1);
+#endif
+        return true;
+    }
+};
+
+} // namespace mrf
+
+#endif // MRF_SPSCRING_H
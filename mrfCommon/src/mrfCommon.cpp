@@ -5,6 +5,11 @@
 #include <limits.h>
 #include <stdlib.h>
 
+#ifdef __linux__
+#  include <pthread.h>
+#  include <sched.h>
+#endif
+
 #include <epicsStdio.h>
 #include <epicsExport.h>
 #include "mrfCommon.h"
@@ -75,6 +80,21 @@ char *allocSNPrintf(size_t N, const char *fmt, ...)
     return mem;
 }
 
+bool mrfSetThreadCPU(int cpu)
+{
+#ifdef __linux__
+    if(cpu<0 || cpu>=CPU_SETSIZE)
+        return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set)==0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
 #if (EPICS_VERSION_INT < VERSION_INT(3,15,0,2))
 
 static
@@ -333,6 +333,11 @@ public:
 epicsShareFunc epicsUInt32 roundToUInt(double val, epicsUInt32 maxresult=0xffffffff);
 
 epicsShareFunc char *allocSNPrintf(size_t N, const char *fmt, ...) EPICS_PRINTF_STYLE(2,3);
+
+/* Restrict the calling thread to run only on the given CPU (zero indexed).
+ * Returns false if this fails, or is not supported by the target OS.
+ */
+epicsShareFunc bool mrfSetThreadCPU(int cpu);
 #endif
 
 /**************************************************************************************************/
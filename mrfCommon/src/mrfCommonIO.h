@@ -100,9 +100,58 @@
 
 #include <epicsEndian.h>        /* OS-independent macros for system endianness checking           */
 #include <epicsMMIO.h>          /* OS-dependent synchronous I/O routines                          */
+#include <mrf/simio.h>          /* Hooks for simulated devices (MRF_SIM_IO)                       */
 #include <mrfBitOps.h>          /* Generic bit operations                                         */
 #include <stdexcept>
 
+/* With MRF_SIM_IO, offer accesses to simulated devices first (see mrf/simio.h) */
+#ifdef MRF_SIM_IO
+
+#ifdef __cplusplus
+#  define MRF_SIM_INLINE static inline
+#else
+#  define MRF_SIM_INLINE static __inline__
+#endif
+
+#define MRF_SIM_READ(NAME, W, T) \
+MRF_SIM_INLINE T mrfSim_ ## NAME(volatile void *addr) { \
+    epicsUInt32 simval; \
+    if(mrfSimIOActive && mrfSimIOAccess(addr, W, 0, &simval)) return (T)simval; \
+    return NAME(addr); }
+
+#define MRF_SIM_WRITE(NAME, W, T) \
+MRF_SIM_INLINE void mrfSim_ ## NAME(volatile void *addr, T val) { \
+    epicsUInt32 simval = val; \
+    if(mrfSimIOActive && mrfSimIOAccess(addr, W, 1, &simval)) return; \
+    NAME(addr, val); }
+
+MRF_SIM_READ(ioread8, 8, epicsUInt8)
+MRF_SIM_WRITE(iowrite8, 8, epicsUInt8)
+MRF_SIM_READ(nat_ioread16, 16, epicsUInt16)
+MRF_SIM_WRITE(nat_iowrite16, 16, epicsUInt16)
+MRF_SIM_READ(nat_ioread32, 32, epicsUInt32)
+MRF_SIM_WRITE(nat_iowrite32, 32, epicsUInt32)
+
+#undef MRF_SIM_READ
+#undef MRF_SIM_WRITE
+#undef MRF_SIM_INLINE
+
+/* the originals may be functions or macros */
+#undef ioread8
+#undef iowrite8
+#undef nat_ioread16
+#undef nat_iowrite16
+#undef nat_ioread32
+#undef nat_iowrite32
+#define ioread8(A)          mrfSim_ioread8(A)
+#define iowrite8(A,V)       mrfSim_iowrite8(A,V)
+#define nat_ioread16(A)     mrfSim_nat_ioread16(A)
+#define nat_iowrite16(A,V)  mrfSim_nat_iowrite16(A,V)
+#define nat_ioread32(A)     mrfSim_nat_ioread32(A)
+#define nat_iowrite32(A,V)  mrfSim_nat_iowrite32(A,V)
+
+#endif /* MRF_SIM_IO */
+
 /**************************************************************************************************/
 /*                            Macros For Accessing MRF Timing Modules                             */
 /*            (Note that MRF timing modules are always accessed using native mode I/O             */
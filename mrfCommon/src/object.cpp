@@ -15,6 +15,7 @@ typedef std::map<const std::string, Object::create_factory_t> factories_t;
 static factories_t *factories;
 
 static epicsMutex *objectsLock=0;
+static epicsMutex *propCacheLock=0;
 
 static
 void initObjects(void* rmsg)
@@ -24,6 +25,7 @@ void initObjects(void* rmsg)
         objects = new objects_t;
         factories = new factories_t;
         objectsLock = new epicsMutex;
+        propCacheLock = new epicsMutex;
     } catch(std::exception& e) {
         objects=0;
         *emsg = e.what();
@@ -101,8 +103,19 @@ propertyBase* Object::getPropertyBase(const char*, const std::type_info&)
     return 0;
 }
 
+propertyBase* Object::findPropertyBase(const char*, const std::type_info&)
+{
+    return 0;
+}
+
 void Object::visitProperties(bool (*)(propertyBase*, void*), void*) {}
 
+epicsMutex& Object::propertyCacheLock()
+{
+    initObjectsOnce();
+    return *propCacheLock;
+}
+
 Object*
 Object::getObject(const std::string& n)
 {
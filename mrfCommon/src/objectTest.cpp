@@ -188,6 +188,32 @@ void testOther2()
     testOk1(X.get()!=NULL);
 }
 
+void testFind()
+{
+    testDiag("In testFind()");
+    other m("cached");
+    Object *o = &m;
+
+    property<int> *I=o->findProperty<int>("I");
+    testOk1(I!=NULL);
+    testOk1(I==o->findProperty<int>("I"));
+
+    property<double> *V=o->findProperty<double>("val");
+    testOk1(V!=NULL);
+    testOk1((void*)V!=(void*)o->findProperty<int>("val"));
+
+    property<int> *X=o->findProperty<int>("X");
+    testOk1(X!=NULL && X->get()==42);
+
+    testOk1(o->findProperty<double>("other")==NULL);
+
+    if(I) {
+        I->set(5);
+        testOk1(m.ival==5);
+    } else
+        testSkip(1, "NULL");
+}
+
 void testFactory()
 {
     testDiag("In testFactory()");
@@ -222,10 +248,11 @@ OBJECT_END(other)
 
 MAIN(objectTest)
 {
-    testPlan(39);
+    testPlan(46);
     testMine();
     testOther();
     testOther2();
+    testFind();
     testFactory();
     return testDone();
 }
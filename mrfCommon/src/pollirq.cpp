@@ -3,18 +3,31 @@
 #include <epicsEvent.h>
 #include <epicsMutex.h>
 #include <epicsGuard.h>
+#include <errlog.h>
 #define epicsExportSharedSymbols
+#include "mrfCommon.h"
 #include "mrf/pollirq.h"
 
-IRQPoller::IRQPoller(pollerFN fn, void *arg, double period)
+#include <epicsExport.h>
+
+int mrfIRQPoll = 0;
+double mrfIRQPollPeriod = 0.001;
+int mrfIRQPollCPU = -1;
+
+IRQPoller::IRQPoller(pollerFN fn, void *arg, double period, int cpu, const char *name)
     :done(false)
-    ,period(0.1)
+    ,period(period>0.0 ? period : 0.0)
+    ,cpu(cpu)
     ,fn(fn)
     ,arg(arg)
-    ,runner(*this, "IRQPoller",
+    ,count(0u)
+    ,meanLoop(0.0)
+    ,runner(*this, name,
             epicsThreadGetStackSize(epicsThreadStackBig),
             epicsThreadPriorityHigh)
 {
+    if(this->period==0.0 && cpu<0)
+        errlogPrintf("%s: Warning: busy-poll without a CPU selected\n", name);
     runner.start();
 }
 
@@ -27,16 +40,46 @@ IRQPoller::~IRQPoller()
     runner.exitWait();
 }
 
-void IRQPoller::run()
+double IRQPoller::loopTime() const
 {
     epicsGuard<epicsMutex> G(lock);
+    return meanLoop;
+}
+
+void IRQPoller::run()
+{
+    if(cpu>=0 && !mrfSetThreadCPU(cpu))
+        errlogPrintf("%s: Unable to pin to CPU %d\n", epicsThreadGetNameSelf(), cpu);
+
+    // Statistics are kept locally and published about every 0.1 sec. when sleeping,
+    // or every 1024 calls when busy-polling, to keep the lock out of the loop.
+    const epicsUInt32 batch = period>0.0 ? epicsUInt32(0.1/period)+1u : 1024u;
+    epicsUInt32 n = 0u;
+    epicsTimeStamp last, now;
+    epicsTimeGetCurrent(&last);
+
     while(!done) {
-        double P = period;
-        {
-            epicsGuardRelease<epicsMutex> U(G);
-            epicsThreadSleep(P);
-        }
+        if(period>0.0)
+            epicsThreadSleep(period);
 
         (*fn)(arg);
+
+        if(++n < batch)
+            continue;
+
+        epicsTimeGetCurrent(&now);
+        {
+            epicsGuard<epicsMutex> G(lock);
+            count += n;
+            meanLoop = epicsTimeDiffInSeconds(&now, &last)/n;
+        }
+        last = now;
+        n = 0u;
     }
 }
+
+extern "C" {
+epicsExportAddress(int, mrfIRQPoll);
+epicsExportAddress(double, mrfIRQPollPeriod);
+epicsExportAddress(int, mrfIRQPollCPU);
+}
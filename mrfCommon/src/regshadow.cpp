@@ -0,0 +1,224 @@
+/*************************************************************************\
+* mrfioc2 is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+#include <stdio.h>
+
+#include <stdexcept>
+#include <list>
+
+#include <epicsThread.h>
+#include <epicsMutex.h>
+#include <iocsh.h>
+
+#define epicsExportSharedSymbols
+#include "mrfCommon.h"
+#include "mrfCommonIO.h"
+#include "mrf/regshadow.h"
+
+#include <epicsExport.h>
+
+namespace {
+
+typedef std::list<mrf::RegShadow*> shadows_t;
+
+epicsMutex *shadowsLock;
+shadows_t *shadows;
+epicsThreadOnceId shadowsOnce = EPICS_THREAD_ONCE_INIT;
+
+void shadowsInit(void*)
+{
+    shadowsLock = new epicsMutex;
+    shadows = new shadows_t;
+}
+
+} // namespace
+
+namespace mrf {
+
+RegShadow::RegShadow(const std::string& name, volatile epicsUInt8 *base,
+                     epicsUInt32 len, epicsMutex& devlock)
+    :base(base)
+    ,len(len)
+    ,name(name)
+    ,devlock(devlock)
+{
+    epicsThreadOnce(&shadowsOnce, &shadowsInit, 0);
+    SCOPED_LOCK2(*shadowsLock, G);
+    shadows->push_back(this);
+}
+
+RegShadow::~RegShadow()
+{
+    SCOPED_LOCK2(*shadowsLock, G);
+    shadows->remove(this);
+}
+
+void RegShadow::cache(epicsUInt32 offset, epicsUInt32 len, epicsUInt32 live)
+{
+    if(offset%4u || len%4u || offset+len>this->len)
+        throw std::out_of_range("Shadow register range out of bounds");
+
+    if((offset+len)/4u>image.size()) {
+        image.resize((offset+len)/4u, 0u);
+        ignore.resize(image.size(), 0u);
+        valid.resize(image.size(), false);
+    }
+
+    for(epicsUInt32 i=offset/4u, end=(offset+len)/4u; i<end; i++) {
+        image[i] = nat_ioread32(base+4u*i);
+        ignore[i] = live;
+        valid[i] = true;
+    }
+}
+
+size_t RegShadow::ncached() const
+{
+    size_t n = 0;
+    for(size_t i=0; i<valid.size(); i++)
+        n += valid[i];
+    return n;
+}
+
+epicsUInt32 RegShadow::read32(epicsUInt32 offset) const
+{
+    if(cached(offset))
+        return image[offset/4u];
+    return nat_ioread32(base+offset);
+}
+
+void RegShadow::write32(epicsUInt32 offset, epicsUInt32 val)
+{
+    nat_iowrite32(base+offset, val);
+    if(cached(offset))
+        image[offset/4u] = val;
+}
+
+epicsUInt32 RegShadow::reload32(epicsUInt32 offset)
+{
+    epicsUInt32 val = nat_ioread32(base+offset);
+    if(cached(offset))
+        image[offset/4u] = val;
+    return val;
+}
+
+size_t RegShadow::verify(bool scrub, bool verbose)
+{
+    size_t ndiff = 0;
+    for(size_t i=0; i<valid.size(); i++) {
+        if(!valid[i])
+            continue;
+        epicsUInt32 actual = nat_ioread32(base+4u*i);
+        if(((actual^image[i])&~ignore[i])==0)
+            continue;
+        ndiff++;
+        if(verbose)
+            printf("%s: 0x%04x card 0x%08x shadow 0x%08x\n", name.c_str(),
+                   (unsigned)(4u*i), (unsigned)actual, (unsigned)image[i]);
+        if(scrub)
+            nat_iowrite32(base+4u*i, image[i]);
+    }
+    return ndiff;
+}
+
+void RegShadow::barrier(epicsUInt32 offset) const
+{
+    (void)nat_ioread32(base+offset);
+}
+
+long RegShadow::verifyByName(const std::string& name, bool scrub)
+{
+    epicsThreadOnce(&shadowsOnce, &shadowsInit, 0);
+    SCOPED_LOCK2(*shadowsLock, G);
+    for(shadows_t::const_iterator it=shadows->begin(), end=shadows->end(); it!=end; ++it) {
+        RegShadow& S = **it;
+        if(S.name!=name)
+            continue;
+        SCOPED_LOCK2(S.devlock, D);
+        return S.verify(scrub);
+    }
+    return -1;
+}
+
+RegBatch::RegBatch(RegShadow& shadow, epicsUInt32 barrierReg, size_t reserve)
+    :shadow(shadow)
+    ,barrierReg(barrierReg)
+{
+    ops.reserve(reserve);
+}
+
+RegBatch::~RegBatch()
+{
+    flush();
+}
+
+void RegBatch::write32(epicsUInt32 offset, epicsUInt32 val)
+{
+    op_t op;
+    op.offset = offset;
+    op.val = val;
+    ops.push_back(op);
+}
+
+void RegBatch::update32(epicsUInt32 offset, epicsUInt32 val)
+{
+    // the most recent write keeps its place in the sequence
+    for(size_t i=ops.size(); i>0; i--) {
+        if(ops[i-1].offset==offset) {
+            ops[i-1].val = val;
+            return;
+        }
+    }
+    write32(offset, val);
+}
+
+epicsUInt32 RegBatch::read32(epicsUInt32 offset) const
+{
+    for(size_t i=ops.size(); i>0; i--) {
+        if(ops[i-1].offset==offset)
+            return ops[i-1].val;
+    }
+    return shadow.read32(offset);
+}
+
+void RegBatch::flush()
+{
+    if(ops.empty())
+        return;
+    for(size_t i=0; i<ops.size(); i++)
+        shadow.write32(ops[i].offset, ops[i].val);
+    shadow.barrier(barrierReg);
+    ops.clear();
+}
+
+} // namespace mrf
+
+static const iocshArg mrfShadowVerifyArg0 = { "name",iocshArgString};
+static const iocshArg mrfShadowVerifyArg1 = { "scrub",iocshArgInt};
+static const iocshArg * const mrfShadowVerifyArgs[2] =
+    {&mrfShadowVerifyArg0,&mrfShadowVerifyArg1};
+static const iocshFuncDef mrfShadowVerifyFuncDef =
+    {"mrfShadowVerify",2,mrfShadowVerifyArgs};
+static void mrfShadowVerifyCall(const iocshArgBuf *args)
+{
+    if(!args[0].sval) {
+        printf("Usage: mrfShadowVerify(\"name\", scrub)\n");
+        return;
+    }
+    long ndiff = mrf::RegShadow::verifyByName(args[0].sval, args[1].ival);
+    if(ndiff<0)
+        printf("Error: %s has no register shadow\n", args[0].sval);
+    else
+        printf("%s: %ld registers differ%s\n", args[0].sval, ndiff,
+               ndiff && args[1].ival ? ", re-written" : "");
+}
+
+static void regShadowReg()
+{
+    iocshRegister(&mrfShadowVerifyFuncDef, &mrfShadowVerifyCall);
+}
+
+extern "C" {
+epicsExportRegistrar(regShadowReg);
+}
@@ -0,0 +1,132 @@
+#include <epicsMutex.h>
+#include "epicsUnitTest.h"
+#include "testMain.h"
+
+#include "mrfCommonIO.h"
+#include "mrf/regshadow.h"
+
+#define U32_Cfg    0x0
+#define U32_Status 0x4
+#define U32_Ctrl   0x8
+
+namespace {
+
+epicsUInt32 regs[4];
+
+// host memory is in native order
+volatile epicsUInt8 *base() { return (volatile epicsUInt8*)regs; }
+
+void testCache()
+{
+    testDiag("testCache()");
+    epicsMutex lock;
+
+    regs[0] = 0x1234;
+    regs[1] = 0;
+    regs[2] = 0x80;
+
+    mrf::RegShadow S("test", base(), sizeof(regs), lock);
+    S.cache(U32_Cfg);
+    S.cache(U32_Ctrl, 4, 0x80);
+
+    testOk1(S.ncached()==2);
+    testOk1(S.cached(U32_Cfg) && !S.cached(U32_Status));
+    testOk1(SHADOW_READ32(S, Cfg)==0x1234);
+
+    // reads of cached registers don't touch the card
+    regs[0] = 0x5678;
+    testOk1(SHADOW_READ32(S, Cfg)==0x1234);
+    // others do
+    regs[1] = 42;
+    testOk1(SHADOW_READ32(S, Status)==42);
+
+    SHADOW_WRITE32(S, Cfg, 0x9);
+    testOk1(regs[0]==0x9 && SHADOW_READ32(S, Cfg)==0x9);
+
+    SHADOW_BITSET32(S, Ctrl, 0x3);
+    testOk1(regs[2]==0x83);
+    SHADOW_BITCLR32(S, Ctrl, 0x1);
+    testOk1(regs[2]==0x82);
+
+    testOk1(S.verify(false, false)==0);
+
+    // live bit changed by the card is not a difference
+    regs[2] = 0x02;
+    testOk1(S.verify(false, false)==0);
+
+    testOk1(mrf::RegShadow::verifyByName("nonexistent", false)==-1);
+}
+
+void testScrub()
+{
+    testDiag("testScrub()");
+    epicsMutex lock;
+
+    regs[0] = 1;
+    regs[2] = 2;
+
+    mrf::RegShadow S("testScrub", base(), sizeof(regs), lock);
+    S.cache(U32_Cfg);
+    S.cache(U32_Ctrl);
+
+    // as if from a card reset
+    regs[0] = regs[2] = 0;
+
+    testOk1(S.verify(false, false)==2);
+    testOk1(regs[0]==0);
+    testOk1(mrf::RegShadow::verifyByName("testScrub", true)==2);
+    testOk1(regs[0]==1 && regs[2]==2);
+    testOk1(S.verify(false, false)==0);
+
+    regs[2] = 3;
+    testOk1(SHADOW_RELOAD32(S, Ctrl)==3);
+    testOk1(SHADOW_READ32(S, Ctrl)==3);
+}
+
+void testBatch()
+{
+    testDiag("testBatch()");
+    epicsMutex lock;
+
+    regs[0] = 1;
+    regs[1] = 0;
+    regs[2] = 0;
+
+    mrf::RegShadow S("testBatch", base(), sizeof(regs), lock);
+    S.cache(U32_Cfg);
+
+    {
+        mrf::RegBatch B(S, U32_Status);
+        BATCH_WRITE32(B, Ctrl, 1);
+        BATCH_WRITE32(B, Cfg, 5);
+        BATCH_WRITE32(B, Ctrl, 2);
+        testOk1(B.pending()==3);
+        testOk1(regs[0]==1 && regs[2]==0);
+        testOk1(B.read32(U32_Ctrl)==2);
+        testOk1(B.read32(U32_Cfg)==5);
+
+        BATCH_UPDATE32(B, Cfg, 6);
+        BATCH_UPDATE32(B, Status, 7);
+        testOk1(B.pending()==4);
+
+        B.flush();
+        testOk1(B.pending()==0);
+        testOk1(regs[0]==6 && regs[1]==7 && regs[2]==2);
+        testOk1(SHADOW_READ32(S, Cfg)==6);
+
+        BATCH_WRITE32(B, Ctrl, 3);
+    }
+    // flushed when destroyed
+    testOk1(regs[2]==3);
+}
+
+} // namespace
+
+MAIN(regshadowTest)
+{
+    testPlan(27);
+    testCache();
+    testScrub();
+    testBatch();
+    return testDone();
+}
@@ -0,0 +1,93 @@
+#include <epicsThread.h>
+#include "epicsUnitTest.h"
+#include "testMain.h"
+
+#include "mrf/seqlock.h"
+
+namespace {
+
+struct pair_t {
+    unsigned a, b; // b == ~a
+};
+
+typedef mrf::SeqLocked<pair_t> seq_t;
+
+void testBasic()
+{
+    testDiag("testBasic()");
+
+    seq_t S;
+    pair_t v;
+
+    testOk1(S.tryLoad(v) && v.a==0 && v.b==0);
+
+    v.a = 1; v.b = ~1u;
+    S.store(v);
+    v.a = v.b = 0;
+    testOk1(S.tryLoad(v) && v.a==1 && v.b==~1u);
+    testOk1(S.loadExcl().a==1);
+}
+
+struct writer : public epicsThreadRunable {
+    seq_t& S;
+    const unsigned count;
+    explicit writer(seq_t& S, unsigned count) :S(S), count(count) {}
+    virtual void run()
+    {
+        for(unsigned i=1; i<=count; i++) {
+            pair_t v;
+            v.a = i;
+            v.b = ~i;
+            S.store(v);
+        }
+    }
+};
+
+void testThreads()
+{
+    testDiag("testThreads()");
+
+    const unsigned count = 1000000;
+    seq_t S;
+    {
+        pair_t v;
+        v.a = 0;
+        v.b = ~0u;
+        S.store(v);
+    }
+    writer W(S, count);
+    epicsThread T(W, "writer", epicsThreadGetStackSize(epicsThreadStackSmall));
+    T.start();
+
+    unsigned torn=0, backward=0, prev=0, nok=0;
+    while(prev<count) {
+        pair_t v;
+        if(!S.tryLoad(v))
+            continue;
+        nok++;
+        if(v.b!=~v.a)
+            torn++;
+        if(v.a<prev)
+            backward++;
+        prev = v.a;
+    }
+    T.exitWait();
+
+    testOk(torn==0, "torn reads %u", torn);
+    testOk(backward==0, "went backwards %u", backward);
+    testDiag("%u successful reads", nok);
+}
+
+} // namespace
+
+MAIN(seqlockTest)
+{
+    testPlan(5);
+#ifdef MRF_SEQLOCK_ATOMIC
+    testBasic();
+    testThreads();
+#else
+    testSkip(5, "tryLoad() needs epicsAtomic.h");
+#endif
+    return testDone();
+}
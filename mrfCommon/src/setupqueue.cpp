@@ -0,0 +1,207 @@
+/*************************************************************************\
+* mrfioc2 is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+#include <stdio.h>
+
+#include <stdexcept>
+#include <vector>
+
+#include <epicsThread.h>
+#include <epicsMutex.h>
+#include <epicsTime.h>
+#include <epicsStdio.h>
+#include <errlog.h>
+#include <initHooks.h>
+#include <iocsh.h>
+
+#define epicsExportSharedSymbols
+#include "mrfCommon.h"
+#include "mrf/setupqueue.h"
+
+#include <epicsExport.h>
+
+extern "C" {
+int mrfSetupThreads = 0;
+}
+
+namespace {
+
+struct entry {
+    mrf::SetupJob *job;
+    double elapsed;
+    bool ok;
+};
+typedef std::vector<entry> entries_t;
+
+epicsMutex *setupLock;
+entries_t *queued;
+// index of next job to run, guarded by setupLock
+size_t nextJob;
+// set once wait() has begun.  Later submissions run immediately.
+bool started;
+
+epicsThreadOnceId setupOnce = EPICS_THREAD_ONCE_INIT;
+
+void setupInit(void*)
+{
+    setupLock = new epicsMutex;
+    queued = new entries_t;
+}
+
+void runOne(entry& E)
+{
+    epicsTimeStamp start, end;
+    epicsTimeGetCurrent(&start);
+    try {
+        E.job->run();
+        E.ok = true;
+    } catch(std::exception& e) {
+        printf("%s: Error: %s\n", E.job->name.c_str(), e.what());
+        E.ok = false;
+    }
+    epicsTimeGetCurrent(&end);
+    E.elapsed = epicsTimeDiffInSeconds(&end, &start);
+    errlogFlush();
+}
+
+struct setupWorker : public epicsThreadRunable
+{
+    epicsThread thread;
+
+    explicit setupWorker(const char *name)
+        :thread(*this, name,
+                epicsThreadGetStackSize(epicsThreadStackBig),
+                epicsThreadPriorityMedium)
+    {}
+    virtual ~setupWorker() {}
+
+    virtual void run()
+    {
+        while(true) {
+            size_t idx;
+            {
+                SCOPED_LOCK2(*setupLock, G);
+                if(nextJob>=queued->size())
+                    return;
+                idx = nextJob++;
+            }
+            // each worker writes only its own entries
+            runOne((*queued)[idx]);
+        }
+    }
+};
+
+} // namespace
+
+namespace mrf {
+
+void SetupQueue::submit(SetupJob *job)
+{
+    epicsThreadOnce(&setupOnce, &setupInit, 0);
+    {
+        SCOPED_LOCK2(*setupLock, G);
+        if(!started && mrfSetupThreads>0) {
+            for(entries_t::const_iterator it=queued->begin(), end=queued->end(); it!=end; ++it) {
+                if(it->job->name==job->name) {
+                    delete job;
+                    throw std::runtime_error("ID already queued for setup");
+                }
+            }
+            entry E;
+            E.job = job;
+            E.elapsed = 0.0;
+            E.ok = false;
+            queued->push_back(E);
+            printf("%s: setup queued\n", job->name.c_str());
+            return;
+        }
+    }
+
+    auto_ptr<SetupJob> J(job);
+    J->run();
+}
+
+void SetupQueue::wait()
+{
+    epicsThreadOnce(&setupOnce, &setupInit, 0);
+    {
+        SCOPED_LOCK2(*setupLock, G);
+        if(started)
+            return;
+        started = true;
+        nextJob = 0;
+    }
+    // no further additions to 'queued' from here
+
+    if(queued->empty())
+        return;
+
+    size_t nthreads = mrfSetupThreads;
+    if(nthreads > queued->size())
+        nthreads = queued->size();
+
+    printf("Setup %u cards with %u threads\n",
+           (unsigned)queued->size(), (unsigned)nthreads);
+
+    epicsTimeStamp T0, T1;
+    epicsTimeGetCurrent(&T0);
+    {
+        std::vector<setupWorker*> workers(nthreads);
+        for(size_t i=0; i<nthreads; i++) {
+            char name[16];
+            epicsSnprintf(name, sizeof(name), "mrfSetup%u", (unsigned)i);
+            workers[i] = new setupWorker(name);
+            workers[i]->thread.start();
+        }
+        // join barrier
+        for(size_t i=0; i<nthreads; i++) {
+            workers[i]->thread.exitWait();
+            delete workers[i];
+        }
+    }
+    epicsTimeGetCurrent(&T1);
+
+    unsigned nfail = 0;
+    double serial = 0.0;
+    printf("%-20s %10s\n", "Card", "Time (s)");
+    for(entries_t::iterator it=queued->begin(), end=queued->end(); it!=end; ++it) {
+        printf("%-20s %10.3f%s\n", it->job->name.c_str(), it->elapsed,
+               it->ok ? "" : "  FAILED");
+        serial += it->elapsed;
+        if(!it->ok)
+            nfail++;
+        delete it->job;
+    }
+    printf("Setup complete in %.3f s (%.3f s if serial).  %u failed\n",
+           epicsTimeDiffInSeconds(&T1, &T0), serial, nfail);
+
+    queued->clear();
+}
+
+} // namespace mrf
+
+static void setupQueueHook(initHookState state)
+{
+    if(state==initHookAtBeginning)
+        mrf::SetupQueue::wait();
+}
+
+static const iocshFuncDef mrfSetupWaitFuncDef =
+    {"mrfSetupWait",0,0};
+static void mrfSetupWaitCall(const iocshArgBuf *)
+{
+    mrf::SetupQueue::wait();
+}
+
+static void setupQueueReg()
+{
+    initHookRegister(&setupQueueHook);
+    iocshRegister(&mrfSetupWaitFuncDef, &mrfSetupWaitCall);
+}
+
+extern "C" {
+epicsExportRegistrar(setupQueueReg);
+epicsExportAddress(int, mrfSetupThreads);
+}
@@ -0,0 +1,70 @@
+/*************************************************************************\
+* mrfioc2 is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+#include <stdexcept>
+
+#include <epicsMutex.h>
+#include <epicsThread.h>
+#include <dbDefs.h>
+
+#define epicsExportSharedSymbols
+#include "mrfCommon.h"
+#include "mrf/simio.h"
+
+namespace {
+
+struct region {
+    volatile epicsUInt8 *base;
+    epicsUInt32 len;
+    mrfSimIOFn fn;
+    void *pvt;
+};
+
+// only a few simulated cards are expected
+region regions[8];
+
+epicsMutex *simLock;
+epicsThreadOnceId simOnce = EPICS_THREAD_ONCE_INIT;
+
+void simInit(void*)
+{
+    simLock = new epicsMutex;
+}
+
+} // namespace
+
+int mrfSimIOActive;
+
+void mrfSimIORegister(volatile void *base, epicsUInt32 len,
+                      mrfSimIOFn fn, void *pvt)
+{
+    epicsThreadOnce(&simOnce, &simInit, 0);
+    SCOPED_LOCK2(*simLock, G);
+
+    if(size_t(mrfSimIOActive)>=NELEMENTS(regions))
+        throw std::runtime_error("Too many simulated devices");
+
+    region& R = regions[mrfSimIOActive];
+    R.base = (volatile epicsUInt8*)base;
+    R.len = len;
+    R.fn = fn;
+    R.pvt = pvt;
+    // readers don't lock.  Regions are registered before the device object
+    // is created, so other threads see a complete entry through the locking
+    // done when they find the device.
+    mrfSimIOActive++;
+}
+
+int mrfSimIOAccess(volatile void *addr, unsigned width,
+                   int write, epicsUInt32 *val)
+{
+    volatile epicsUInt8 *A = (volatile epicsUInt8*)addr;
+    for(int i=0; i<mrfSimIOActive; i++) {
+        const region& R = regions[i];
+        if(A>=R.base && A<R.base+R.len)
+            return (*R.fn)(R.pvt, epicsUInt32(A-R.base), width, write, val);
+    }
+    return 0;
+}
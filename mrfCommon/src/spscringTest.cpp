@@ -0,0 +1,104 @@
+#include <epicsThread.h>
+#include "epicsUnitTest.h"
+#include "testMain.h"
+
+#include "mrf/spscring.h"
+
+namespace {
+
+typedef mrf::SPSCRing<unsigned, 4> ring4_t;
+
+void testBasic()
+{
+    testDiag("testBasic()");
+
+    ring4_t R;
+    unsigned v = 42;
+
+    testOk1(R.size()==0);
+    testOk1(!R.pop(v));
+    testOk1(v==42);
+
+    testOk1(R.push(1));
+    testOk1(R.push(2));
+    testOk1(R.push(3));
+    testOk1(R.push(4));
+    testOk1(R.size()==4);
+    testOk1(!R.push(5));
+
+    testOk1(R.pop(v) && v==1);
+    testOk1(R.pop(v) && v==2);
+    testOk1(R.size()==2);
+}
+
+void testWrap()
+{
+    testDiag("testWrap()");
+
+    ring4_t R;
+    unsigned v, bad = 0;
+
+    // run the free running counters many times around
+    for(unsigned i=0; i<1000; i++) {
+        if(!R.push(i) || !R.push(i+1) || !R.push(i+2))
+            bad++;
+        if(!R.pop(v) || v!=i || !R.pop(v) || v!=i+1 || !R.pop(v) || v!=i+2)
+            bad++;
+    }
+    testOk(bad==0, "bad=%u", bad);
+    testOk1(R.size()==0);
+}
+
+typedef mrf::SPSCRing<unsigned, 64> ring64_t;
+
+struct producer : public epicsThreadRunable {
+    ring64_t& R;
+    const unsigned count;
+    explicit producer(ring64_t& R, unsigned count) :R(R), count(count) {}
+    virtual void run()
+    {
+        for(unsigned i=0; i<count; ) {
+            if(R.push(i))
+                i++;
+            else
+                epicsThreadSleep(0.0);
+        }
+    }
+};
+
+void testThreads()
+{
+    testDiag("testThreads()");
+
+    const unsigned count = 100000;
+    ring64_t R;
+    producer P(R, count);
+    epicsThread T(P, "producer", epicsThreadGetStackSize(epicsThreadStackSmall));
+    T.start();
+
+    unsigned v, expect=0, bad=0;
+    while(expect<count) {
+        if(!R.pop(v)) {
+            epicsThreadSleep(0.0);
+            continue;
+        }
+        if(v!=expect)
+            bad++;
+        expect++;
+    }
+    T.exitWait();
+
+    testOk(bad==0, "out of order %u", bad);
+    testOk1(R.size()==0);
+}
+
+} // namespace
+
+MAIN(spscringTest)
+{
+    testPlan(16);
+    testBasic();
+    testWrap();
+    testThreads();
+    return testDone();
+}
@@ -11,6 +11,7 @@
 #include <waveformRecord.h>
 #include <menuFtype.h>
 #include <epicsEndian.h>
+#include <callback.h>
 
 #ifdef _WIN32
  #include <Winsock2.h>
@@ -39,6 +40,10 @@ struct s_priv
 
   dataBufTx *priv;
   epicsUInt8 *scratch;
+
+  // async. completion of dataSendAsync()
+  CALLBACK txcb;
+  epicsStatus txstatus;
 };
 
 static const
@@ -77,6 +82,8 @@ try {
   else
       paddr->scratch = 0;
 
+  paddr->txstatus = 0;
+
   // prec->dpvt is set again to indicate
   // This also serves to indicate successful
   // initialization to other dset functions
@@ -113,12 +120,28 @@ static long del_record_waveform(dbCommon *praw)
     return ret;
 }
 
+static void txdone(void *arg, epicsStatus ok, epicsUInt32, const epicsUInt8*)
+{
+  waveformRecord *prec=(waveformRecord*)arg;
+  s_priv *paddr=static_cast<s_priv*>(prec->dpvt);
+
+  paddr->txstatus=ok;
+  callbackRequestProcessCallback(&paddr->txcb, priorityMedium, prec);
+}
+
 static long write_waveform(waveformRecord* prec)
 {
   if (!prec->dpvt) {(void)recGblSetSevr(prec, COMM_ALARM, INVALID_ALARM); return -1; }
-try {
   s_priv *paddr=static_cast<s_priv*>(prec->dpvt);
 
+  if (prec->pact) {
+    // Tx complete
+    if (paddr->txstatus)
+      (void)recGblSetSevr(prec, WRITE_ALARM, INVALID_ALARM);
+    return 0;
+  }
+try {
+
   epicsUInt32 capacity=paddr->priv->lenMax();
   const long esize=dbValueSize(prec->ftvl);
   epicsUInt32 requested=prec->nord*esize;
@@ -152,10 +175,14 @@ try {
       }
   }
 
-  paddr->priv->dataSend(requested,buf);
+  // buf is copied before dataSendAsync() returns.
+  // The record completes when txdone() is called.
+  prec->pact=TRUE;
+  paddr->priv->dataSendAsync(requested,buf,&txdone,(void*)prec);
 
   return 0;
 } catch(std::exception& e) {
+  prec->pact=FALSE;
   recGblRecordError(S_db_noMemory, (void*)prec, e.what());
   return S_db_noMemory;
 }
@@ -6,10 +6,12 @@
 * in file LICENSE that is included with this distribution.
 \*************************************************************************/
 #include <cstdio>
+#include <cstring>
 #include <stdexcept>
 
 #include <epicsTypes.h>
 
+#include <errlog.h>
 #include <epicsThread.h>
 #include <epicsInterrupt.h>
 
@@ -29,6 +31,9 @@
 #define DataTxCtrl_len_mask 0x0007fc
 #define DataTxCtrl_len_max  DataTxCtrl_len_mask
 
+// Number of buffers which dataSendAsync() may queue
+#define TX_QUEUE_DEPTH 4
+
 mrmDataBufTx::mrmDataBufTx(const std::string& n,
                  volatile epicsUInt8* bufcontrol,
                  volatile epicsUInt8* buffer
@@ -36,11 +41,33 @@ mrmDataBufTx::mrmDataBufTx(const std::string& n,
   ,dataCtrl(bufcontrol)
   ,dataBuf(buffer)
   ,dataGuard()
+  ,txAllocated(0)
+  ,txStarted(false)
+  ,txStop(false)
+  ,txWorkerMethod(*this)
+  ,txTask(txWorkerMethod, "BUFTX",
+          epicsThreadGetStackSize(epicsThreadStackSmall),
+          epicsThreadPriorityHigh)
 {
 }
 
 mrmDataBufTx::~mrmDataBufTx()
 {
+    bool started;
+    {
+        SCOPED_LOCK(txGuard);
+        started = txStarted;
+        txStop = true;
+    }
+    if(started) {
+        txWakeup.signal();
+        txTask.exitWait();
+    }
+    // Completion functions for any unsent buffers are not called
+    for(size_t i=0; i<txPending.size(); i++)
+        delete txPending[i];
+    for(size_t i=0; i<txFree.size(); i++)
+        delete txFree[i];
 }
 
 bool
@@ -86,6 +113,38 @@ mrmDataBufTx::lenMax() const
     return DataTxCtrl_len_max;
 }
 
+bool
+mrmDataBufTx::sendLocked(epicsUInt32 len, const epicsUInt8 *ubuf)
+{
+    // Zero length
+    // Seems to be required?
+    nat_iowrite32(dataCtrl, DataTxCtrl_ena|DataTxCtrl_mode);
+
+    // Write 4 byte words over VME
+    epicsUInt32 index;
+    for(index=0; index<len; index+=4) {
+        be_iowrite32(&dataBuf[index], *(epicsUInt32*)(&ubuf[index]) );
+    }
+
+    nat_iowrite32(dataCtrl, len|DataTxCtrl_trig|DataTxCtrl_ena|DataTxCtrl_mode);
+
+    // Reading flushes output queue of VME bridge
+    // Actual sending is so fast that we can use busy wait here
+    // Measurements showed that we loop up to 17 times
+    for(unsigned i=0; i<64; i++) {
+        if(nat_ioread32(dataCtrl)&DataTxCtrl_done)
+            return true;
+    }
+
+    // There is no Tx done interrupt.  Give up the CPU between polls.
+    for(unsigned i=0; i<100; i++) {
+        epicsThreadSleep(epicsThreadSleepQuantum());
+        if(nat_ioread32(dataCtrl)&DataTxCtrl_done)
+            return true;
+    }
+    return false;
+}
+
 void
 mrmDataBufTx::dataSend(epicsUInt32 len,
                        const epicsUInt8 *ubuf
@@ -101,20 +160,91 @@ mrmDataBufTx::dataSend(epicsUInt32 len,
 
     SCOPED_LOCK(dataGuard);
 
-    // Zero length
-    // Seems to be required?
-    nat_iowrite32(dataCtrl, DataTxCtrl_ena|DataTxCtrl_mode);
+    if(!sendLocked(len, ubuf))
+        throw std::runtime_error("Timeout sending Tx buffer");
+}
 
-    // Write 4 byte words over VME
-    epicsUInt32 index;
-    for(index=0; index<len; index+=4) {
-        be_iowrite32(&dataBuf[index], *(epicsUInt32*)(&ubuf[index]) );
+void
+mrmDataBufTx::dataSendAsync(epicsUInt32 len, const epicsUInt8 *ubuf,
+                            dataBufComplete fptr, void *arg)
+{
+    if (len > DataTxCtrl_len_max)
+        throw std::out_of_range("Tx buffer is too long");
+
+    txRequest *req = NULL;
+    bool start = false;
+    {
+        SCOPED_LOCK(txGuard);
+
+        if(!txFree.empty()) {
+            req = txFree.back();
+            txFree.pop_back();
+        } else if(txAllocated<TX_QUEUE_DEPTH) {
+            req = new txRequest;
+            req->data.resize(DataTxCtrl_len_max);
+            txAllocated++;
+        }
+
+        if(req) {
+            // len must be a multiple of 4
+            req->len = len&DataTxCtrl_len_mask;
+            req->ubuf = ubuf;
+            req->fptr = fptr;
+            req->arg = arg;
+            memcpy(&req->data[0], ubuf, req->len);
+
+            txPending.push_back(req);
+
+            start = !txStarted;
+            txStarted = true;
+        }
     }
 
-    nat_iowrite32(dataCtrl, len|DataTxCtrl_trig|DataTxCtrl_ena|DataTxCtrl_mode);
+    if(!req) {
+        if(fptr)
+            (*fptr)(arg, 1, len, ubuf);
+        return;
+    }
 
-    // Reading flushes output queue of VME bridge
-    // Actual sending is so fast that we can use busy wait here
-    // Measurements showed that we loop up to 17 times
-    while(!(nat_ioread32(dataCtrl)&DataTxCtrl_done)) {};
+    if(start)
+        txTask.start();
+    txWakeup.signal();
+}
+
+void
+mrmDataBufTx::txWorker()
+{
+    SCOPED_LOCK2(txGuard, G);
+
+    while(!txStop) {
+        if(txPending.empty()) {
+            G.unlock();
+            txWakeup.wait();
+            G.lock();
+            continue;
+        }
+
+        txRequest *req = txPending.front();
+        txPending.pop_front();
+
+        G.unlock();
+
+        bool ok;
+        {
+            SCOPED_LOCK(dataGuard);
+            ok = sendLocked(req->len, &req->data[0]);
+        }
+
+        if(req->fptr) {
+            try {
+                (*req->fptr)(req->arg, ok ? 0 : 2, req->len, req->ubuf);
+            } catch(std::exception& e) {
+                errlogPrintf("%s: exception in Tx completion: %s\n", name().c_str(), e.what());
+            }
+        }
+
+        G.lock();
+
+        txFree.push_back(req);
+    }
 }
@@ -8,8 +8,14 @@
 #ifndef MRMDATABUFTX_H_INC
 #define MRMDATABUFTX_H_INC
 
+#include <deque>
+#include <vector>
+
 #include <epicsMutex.h>
+#include <epicsEvent.h>
+#include <epicsThread.h>
 
+#include "mrfCommon.h"
 #include "mrf/databuf.h"
 
 /**
@@ -38,11 +44,40 @@ public:
 
     virtual void dataSend(epicsUInt32 len, const epicsUInt8 *buf) OVERRIDE FINAL;
 
+    /** Buffers are copied into one of a few preallocated slots
+     *  and sent by a worker thread, started on first use.
+     */
+    virtual void dataSendAsync(epicsUInt32 len, const epicsUInt8 *buf,
+                               dataBufComplete fptr, void *arg=0) OVERRIDE FINAL;
+
 private:
     volatile epicsUInt8 * const dataCtrl;
     volatile epicsUInt8 * const dataBuf;
 
     epicsMutex dataGuard;
+
+    // Write and trigger.  Caller must hold dataGuard
+    bool sendLocked(epicsUInt32 len, const epicsUInt8 *buf);
+
+    struct txRequest {
+        epicsUInt32 len;
+        const epicsUInt8 *ubuf;
+        dataBufComplete fptr;
+        void *arg;
+        std::vector<epicsUInt8> data;
+    };
+
+    // Async send queue.  Guarded by txGuard
+    epicsMutex txGuard;
+    std::deque<txRequest*> txPending;
+    std::vector<txRequest*> txFree;
+    size_t txAllocated;
+    bool txStarted, txStop;
+
+    epicsEvent txWakeup;
+    void txWorker();
+    epicsThreadRunableMethod<mrmDataBufTx, &mrmDataBufTx::txWorker> txWorkerMethod;
+    epicsThread txTask;
 };
 
 #endif // MRMDATABUFTX_H_INC
@@ -13,6 +13,7 @@
 #include <epicsMath.h>
 #include <epicsMutex.h>
 #include <errlog.h>
+#include <callback.h>
 
 #include <mrfCommonIO.h>
 
@@ -49,6 +50,9 @@ namespace {
 
 enum RunMode {Normal=0, Single=2};
 
+//! SoftSequence::hw_seg etc. when the RAM holds no segment of the committed sequence
+const size_t noSeg = size_t(-1);
+
 }//namespace
 
 struct SoftSequence;
@@ -70,6 +74,15 @@ struct SeqHW
     epicsUInt32 ctrlreg_user, //!< user requested (based on commited sequence)
                 ctrlreg_hw;   //!< current in HW.  either same as _user or trigger disabled
 
+    enum {RAMLen=SeqManager::RAMLen};
+
+    //! Host copy of the RAM, as interleaved time and code words.
+    //! The first image_valid words are known to match HW.
+    //! Allocated up front as it is updated from ISR context.
+    //! Guarded as the RAM itself, by interruptLock unless this is a standby.
+    std::vector<epicsUInt32> image;
+    size_t image_valid;
+
     SeqHW(SeqManager * o,
           unsigned i,
           volatile void *ctrl,
@@ -82,6 +95,8 @@ struct SeqHW
         ,running(false)
         ,ctrlreg_user(0u)
         ,ctrlreg_hw(0u)
+        ,image(2*RAMLen, 0u)
+        ,image_valid(0u) // unknown until first written
     {
         switch(owner->type) {
         case SeqManager::TypeEVG:
@@ -98,6 +113,18 @@ struct SeqHW
         nat_iowrite32(ctrlreg, ctrlreg_hw | EVG_SEQ_RAM_RESET);
     }
 
+    //! trigger source code for software trigger
+    epicsUInt8 swTrigSrc() const
+    {
+        switch(owner->type) {
+        case SeqManager::TypeEVG:
+            return 17+idx;
+        case SeqManager::TypeEVR:
+            return 61;
+        }
+        return 0;
+    }
+
     // call with interruptLock
     void arm()
     {
@@ -184,18 +211,20 @@ public:
         const double tmult = getTimeScale();
         times_t times(count);
         // check for monotonic
-        // TODO: not handling overflow (HW supports controlled rollover w/ special 0xffffffff times)
+        // times beyond 32 bits are handled with rollover entries by SeqManager::buildSegments()
         for(epicsUInt32 i=0; i<count; i++)
         {
             if(!finite(arr[i]) || arr[i]<0.0)
                 throw std::runtime_error("times must be finite >=0");
 
-            times[i] = (arr[i]*tmult)+0.5;
+            const double T = (arr[i]*tmult)+0.5;
+            if(T>=ldexp(1.0, 64))
+                throw std::runtime_error("Time overflow");
+
+            times[i] = T;
 
             if(i>0 && times[i]<=times[i-1])
                 throw std::runtime_error("Non-monotonic timestamp array");
-            else if(times[i]==0xffffffff)
-                throw std::runtime_error("Time overflow, rollover not supported");
         }
         {
             SCOPED_LOCK(mutex);
@@ -289,6 +318,8 @@ public:
     // control/status
 
     bool isLoaded() const { SCOPED_LOCK(mutex); return hw; }
+    bool isDoubleBuffered() const { SCOPED_LOCK(mutex); return want_double; }
+    void setDoubleBuffered(bool v);
     bool isEnabled() const { SCOPED_LOCK(mutex); return is_enabled; }
     bool isCommited() const { SCOPED_LOCK(mutex); return is_committed; }
     IOSCANPVT stateChange() const { return changed; }
@@ -304,26 +335,52 @@ public:
     IOSCANPVT counterStartScan() const { return onStart; }
     epicsUInt32 counterEnd() const { interruptLock L; return numEnd; }
     IOSCANPVT counterEndScan() const { return onEnd; }
+    epicsUInt32 counterSwap() const { interruptLock L; return numSwap; }
+    epicsUInt32 counterWritten() const { interruptLock L; return numWritten; }
 
     // internal
 
     void sync();
+    // compute hw->ctrlreg_user and map trigger for the committed sequence.  Call with interruptLock
+    bool configCtrl(SeqHW *target);
+    // make standby active.  Call with interruptLock
+    void swapHW();
+    // start the next segment of a multi-segment sequence.  Called from ISR
+    void nextSegment(bool restart);
+    //! Call with interruptLock
+    bool isStreaming() const
+    { return standby && committed.segs.size()>1 && hw_seg!=noSeg; }
+    // write the segment which will follow hw into standby
+    void refill();
+    static void refillCB(CALLBACK *cb);
 
     SeqManager * const owner;
 
     //! guarded by our mutex and interruptLock
     //! only write when both held
     //! read when either held
+    //! When double buffered, hw and standby are exchanged by swapHW(),
+    //! so only dereference with interruptLock held.
     SeqHW *hw;
+    //! Second HW Seq. when double buffered, otherwise NULL.
+    //! Never triggered.  New sequences are written here, then swapped with 'hw'.
+    SeqHW *standby;
 
     mutable epicsMutex mutex;
 
     typedef std::vector<epicsUInt64> times_t;
     typedef std::vector<epicsUInt8> codes_t;
+    typedef SeqManager::words_t words_t;
+    typedef SeqManager::segments_t segments_t;
+
+    //! @returns the number of RAM words written
+    static epicsUInt32 writeRAM(SeqHW *target, const words_t& words);
 
     struct Config {
         times_t times;
         codes_t codes;
+        //! Built by commit() from times and codes
+        segments_t segs;
         RunMode mode;
         epicsUInt32 src;
         Config()
@@ -334,11 +391,12 @@ public:
         {
             std::swap(times, o.times);
             std::swap(codes, o.codes);
+            std::swap(segs, o.segs);
             std::swap(mode, o.mode);
             std::swap(src, o.src);
         }
     } scratch,   // guarded by our mutex only
-      committed; // guarded by interruptLock only
+      committed; // guarded by interruptLock.  Only changed by commit(), which also holds our mutex
 
     //! Whether user has requested enable
     bool is_enabled;
@@ -349,7 +407,27 @@ public:
     bool is_insync;
 
     //! Guarded by interruptLock only
-    epicsUInt32 numStart, numEnd;
+    epicsUInt32 numStart, numEnd, numSwap;
+    //! RAM words written by the last sync(), double buffered commit(), or refill().
+    //! Guarded by interruptLock only
+    epicsUInt32 numWritten;
+
+    //! Index of the committed.segs held by the hw and standby RAM, or noSeg.
+    //! Guarded by interruptLock only
+    size_t hw_seg, standby_seg;
+    //! # of times the next segment was not ready at the end of the previous.
+    //! Guarded by interruptLock only
+    epicsUInt32 numUnderrun;
+    //! numUnderrun as last reported.  Guarded by our mutex
+    epicsUInt32 lastUnderrun;
+
+    CALLBACK refill_cb;
+
+    //! Use two HW Seq.  Applied on next load().  Guarded by our mutex
+    bool want_double;
+    //! standby holds the committed sequence, waiting for 'hw' to finish.
+    //! Guarded by interruptLock only
+    bool swap_pending;
 
     epicsUInt32 timeScale;
 
@@ -381,6 +459,12 @@ OBJECT_BEGIN(SoftSequence)
   OBJECT_PROP1("NUM_RUNS", &SoftSequence::counterEndScan);
   OBJECT_PROP1("NUM_STARTS", &SoftSequence::counterStart);
   OBJECT_PROP1("NUM_STARTS", &SoftSequence::counterStartScan);
+  OBJECT_PROP1("NUM_SWAPS", &SoftSequence::counterSwap);
+  OBJECT_PROP1("NUM_SWAPS", &SoftSequence::stateChange);
+  OBJECT_PROP1("RAM_WRITES", &SoftSequence::counterWritten);
+  OBJECT_PROP1("RAM_WRITES", &SoftSequence::stateChange);
+  OBJECT_PROP2("DOUBLE_BUFFER", &SoftSequence::isDoubleBuffered, &SoftSequence::setDoubleBuffered);
+  OBJECT_PROP1("DOUBLE_BUFFER", &SoftSequence::stateChange);
   OBJECT_PROP2("TIMEUNITS", &SoftSequence::getTimestampResolution, &SoftSequence::setTimestampResolution);
   OBJECT_PROP2("TRIG_SRC", &SoftSequence::getTrigSrcCt, &SoftSequence::setTrigSrc);
   OBJECT_PROP1("TRIG_SRC", &SoftSequence::stateChange);
@@ -392,17 +476,30 @@ SoftSequence::SoftSequence(SeqManager *o, const std::string& name)
     :base_t(name)
     ,owner(o)
     ,hw(0)
+    ,standby(0)
     ,is_enabled(false)
     ,is_committed(false)
     ,is_insync(false)
     ,numStart(0u)
     ,numEnd(0u)
+    ,numSwap(0u)
+    ,numWritten(0u)
+    ,hw_seg(noSeg)
+    ,standby_seg(noSeg)
+    ,numUnderrun(0u)
+    ,lastUnderrun(0u)
+    ,want_double(false)
+    ,swap_pending(false)
     ,timeScale(0u) // raw/ticks
 {
     scanIoInit(&changed);
     scanIoInit(&onStart);
     scanIoInit(&onEnd);
     scanIoInit(&onErr);
+
+    callbackSetCallback(&SoftSequence::refillCB, &refill_cb);
+    callbackSetPriority(priorityHigh, &refill_cb);
+    callbackSetUser(this, &refill_cb);
 }
 
 SoftSequence::~SoftSequence() {}
@@ -420,6 +517,16 @@ void SoftSequence::softTrig()
     DEBUG(2, ("SW Triggered\n") );
 }
 
+void SoftSequence::setDoubleBuffered(bool v)
+{
+    {
+        SCOPED_LOCK(mutex);
+        want_double = v;
+    }
+    DEBUG(4, ("Set double buffer %c (on next load)\n", v ? 'Y' : 'N'));
+    scanIoRequest(changed);
+}
+
 void SoftSequence::load()
 {
     SCOPED_LOCK(mutex);
@@ -431,14 +538,29 @@ void SoftSequence::load()
         interruptLock L;
 
         is_insync = false; // paranoia
+        swap_pending = false;
+        hw_seg = standby_seg = noSeg;
+
+        SeqHW *found[2] = {0, 0};
+        const size_t nwant = want_double ? 2 : 1;
+        size_t nfound = 0;
 
-        for(size_t i=0, N=owner->hw.size(); i<N; i++) {
+        for(size_t i=0, N=owner->hw.size(); i<N && nfound<nwant; i++) {
             SeqHW *temp = owner->hw[i];
-            if(temp && !temp->loaded) {
-                temp->loaded = this;
-                hw = temp;
-                break;
-            }
+            if(temp && !temp->loaded)
+                found[nfound++] = temp;
+        }
+
+        if(nfound==nwant) {
+            for(size_t i=0; i<nfound; i++)
+                found[i]->loaded = this;
+            hw = found[0];
+            standby = found[1];
+        }
+
+        if(standby) {
+            owner->mapTriggerSrc(standby->idx, 0x02000000);
+            standby->disarm();
         }
 
         if(hw) {
@@ -451,7 +573,7 @@ void SoftSequence::load()
     }
 
     if(!hw) {
-        last_err = "All HW Seq. in use";
+        last_err = want_double ? "Too few free HW Seq. to double buffer" : "All HW Seq. in use";
         scanIoRequest(onErr);
         throw alarm_exception(MAJOR_ALARM, WRITE_ALARM);
     }
@@ -477,7 +599,15 @@ void SoftSequence::unload()
         hw->loaded = NULL;
         hw = NULL;
 
+        if(standby) {
+            standby->disarm();
+            standby->loaded = NULL;
+            standby = NULL;
+        }
+
         is_insync = false;
+        swap_pending = false;
+        hw_seg = standby_seg = noSeg;
     }
 
     scanIoRequest(changed);
@@ -504,9 +634,6 @@ void SoftSequence::commit()
     // ensure presence of trailing end of sequence marker event 0x7f
     if(conf.codes.empty() || conf.codes.back()!=0x7f)
     {
-        if(!conf.times.empty() && conf.times.back()==0xffffffff)
-            throw std::runtime_error("Wow, input array is missing 0x7f and maxing out times");
-
         conf.codes.push_back(0x7f);
 
         if(conf.times.empty())
@@ -515,16 +642,60 @@ void SoftSequence::commit()
             conf.times.push_back(conf.times.back()+1);
     }
 
-    if(conf.times.size()>2048)
-        throw std::runtime_error("Sequence too long");
+    SeqManager::buildSegments(conf.times, conf.codes, conf.segs);
+
+    // following segments are streamed through the second HW Seq.
+    if(conf.segs.size()>1 && !(hw ? standby!=NULL : want_double))
+        throw std::runtime_error("Sequence too long.  Longer sequences need double buffering");
 
     assert(!hw || hw->loaded==this);
 
+    if(standby) {
+        /* Double buffered.  Write the idle standby HW Seq. from this thread,
+         * then swap it with the active one when that is not running.
+         */
+        {
+            interruptLock L;
+            // a pending swap would use the RAM we are about to overwrite
+            swap_pending = false;
+            standby_seg = noSeg;
+            standby->disarm();
+            nat_iowrite32(standby->ctrlreg, standby->ctrlreg_hw | EVG_SEQ_RAM_RESET);
+        }
+
+        // standby is not triggered, and the ISR won't touch it w/o swap_pending
+        epicsUInt32 nwritten = writeRAM(standby, conf.segs[0]);
+
+        {
+            interruptLock L;
+            numWritten = nwritten;
+            committed.swap(conf);
+            is_committed = true;
+            // hw RAM now holds a previous sequence
+            hw_seg = noSeg;
+            standby_seg = 0;
+
+            if(configCtrl(standby)) {
+                swap_pending = true;
+
+                // stop further triggers.  If not running, swap now.
+                // Otherwise swap from doEndOfSequence()
+                if(!hw->disarm())
+                    swapHW();
+            }
+        }
+
+        scanIoRequest(changed);
+        DEBUG(1, ("Committed to standby\n") );
+        return;
+    }
+
     {
         interruptLock L;
         committed.swap(conf);
         is_committed = true;
         is_insync = false;
+        hw_seg = noSeg;
 
         if(hw && !hw->disarm())
             sync();
@@ -590,14 +761,51 @@ void SoftSequence::sync()
     // From paranoia, reset it anyway
     nat_iowrite32(hw->ctrlreg, hw->ctrlreg_hw | EVG_SEQ_RAM_RESET);
 
-    hw->ctrlreg_user &= ~(EVG_SEQ_RAM_REPEAT_MASK|EVG_SEQ_RAM_SRC_MASK);
+    if(committed.segs.size()>1 && !standby) {
+        epicsInterruptContextMessage("SoftSequence::sync() sequence too long w/o double buffering\n");
+        return;
+    }
+
+    if(!configCtrl(hw))
+        return;
+
+    // write out the RAM
+    if(!committed.segs.empty()) {
+        numWritten = writeRAM(hw, committed.segs[0]);
+        hw_seg = 0;
+        DEBUG(3, ("  Wrote %u RAM words\n", (unsigned)numWritten));
+    }
+
+    {
+        epicsUInt32 ctrl = hw->ctrlreg_hw = hw->ctrlreg_user;
+        if(is_enabled)
+            ctrl |= EVG_SEQ_RAM_ARM;
+        else
+            ctrl |= EVG_SEQ_RAM_DISABLE; // paranoia
+
+        DEBUG(3, ("  SeqCtrl %x\n", ctrl));
+        nat_iowrite32(hw->ctrlreg, ctrl);
+    }
+
+    is_insync = true;
+    if(isStreaming())
+        callbackRequest(&refill_cb);
+    scanIoRequest(changed);
+    DEBUG(3, ("In Sync\n") );
+}
+
+
+// Call with interruptLock
+bool SoftSequence::configCtrl(SeqHW *target)
+{
+    target->ctrlreg_user &= ~(EVG_SEQ_RAM_REPEAT_MASK|EVG_SEQ_RAM_SRC_MASK);
 
     switch(committed.mode) {
     case Single:
-        hw->ctrlreg_user |= EVG_SEQ_RAM_SINGLE;
+        target->ctrlreg_user |= EVG_SEQ_RAM_SINGLE;
         break;
     case Normal:
-        hw->ctrlreg_user |= EVG_SEQ_RAM_NORMAL;
+        target->ctrlreg_user |= EVG_SEQ_RAM_NORMAL;
         break;
     }
 
@@ -612,11 +820,11 @@ void SoftSequence::sync()
         src = 63;
         break;
     default:
-        return;
+        return false;
     }
 
     // paranoia: disable any external trigger mappings
-    owner->mapTriggerSrc(hw->idx, 0x02000000);
+    owner->mapTriggerSrc(target->idx, 0x02000000);
 
     // map trigger source codes
     // MSB governs the type of mapping
@@ -629,21 +837,14 @@ void SoftSequence::sync()
     case 0x01000000: // software trigger mapping
         DEBUG(5, ("  SW mapping %x\n", committed.src));
         // ignore 0x00ffffff
-        switch(owner->type) {
-        case SeqManager::TypeEVG:
-            src = 17+hw->idx;
-            break;
-        case SeqManager::TypeEVR:
-            src = 61;
-            break;
-        }
+        src = target->swTrigSrc();
         break;
     case 0x02000000: // external trigger
         DEBUG(5, ("  EXT mapping %x\n", committed.src));
         if(owner->type==SeqManager::TypeEVG) {
             // pass through to sub-class
-            owner->mapTriggerSrc(hw->idx, committed.src);
-            src = 24+hw->idx;
+            owner->mapTriggerSrc(target->idx, committed.src);
+            src = 24+target->idx;
         }
         break;
     case 0x03000000: // disable trigger
@@ -656,18 +857,114 @@ void SoftSequence::sync()
     }
     DEBUG(5, ("  Trig Src %x\n", src));
 
-    hw->ctrlreg_user |= src;
+    target->ctrlreg_user |= src;
 
-    // write out the RAM
-    volatile epicsUInt32 *ram = static_cast<volatile epicsUInt32 *>(hw->rambase);
-    for(size_t i=0, N=committed.codes.size(); i<N; i++)
+    return true;
+}
+
+/* Sequences with times beyond 32 bits, or more than one RAM full of entries,
+ * are split.  The HW counter rolls over to zero after an entry with time
+ * 0xffffffff, so entries with code 0 and this time are inserted as needed.
+ * A full segment is ended with 0x7f one tick after its last entry.
+ * The following segment is timed from there, and is software triggered
+ * from the end of sequence interrupt (cf. nextSegment()).  So later segments
+ * are delayed by the interrupt latency.
+ */
+void SeqManager::buildSegments(const std::vector<epicsUInt64>& times,
+                               const std::vector<epicsUInt8>& codes,
+                               segments_t& segs)
+{
+    const epicsUInt64 rollover = epicsUInt64(1u)<<32;
+    // leave room for end of sequence
+    const size_t maxwords = 2*(RAMLen-1);
+    epicsUInt64 zero = 0, // time at which the HW counter was last zero
+                last = 0; // time of the previous entry
+
+    segs.assign(1, words_t());
+
+    for(size_t i=0, N=std::min(times.size(), codes.size()); i<N; )
     {
-        nat_iowrite32(ram++, committed.times[i]);
-        nat_iowrite32(ram++, committed.codes[i]);
-        if(committed.codes[i]==0x7f)
+        const bool roll = times[i]-zero >= rollover;
+        // only the end of sequence itself may take the last entry.
+        // Not a rollover entry which comes before it.
+        const bool end = !roll && codes[i]==0x7f;
+        words_t& seg = segs.back();
+        epicsUInt32 T, C;
+
+        if(!end && seg.size()>=maxwords) {
+            // segment full
+            last++;
+            seg.push_back(epicsUInt32(last-zero));
+            seg.push_back(0x7f);
+            segs.push_back(words_t());
+            zero = last;
+            continue;
+        }
+
+        if(roll) {
+            T = 0xffffffff;
+            C = 0;
+        } else {
+            T = epicsUInt32(times[i]-zero);
+            C = codes[i];
+            i++;
+        }
+
+        seg.push_back(T);
+        seg.push_back(C);
+        last = zero+T;
+        if(T==0xffffffff)
+            zero += rollover;
+
+        if(end)
             break;
     }
 
+    for(size_t i=0; i<segs.size(); i++) {
+        if(segs[i].size()>2*RAMLen)
+            throw std::logic_error("Sequence segment exceeds HW Seq. RAM");
+    }
+}
+
+/* Only words which differ from the host image are written.
+ * Small edits to a long sequence then need only a few bus writes.
+ * A RAM reset only rewinds the sequencer, so the RAM content, and the image,
+ * remain valid.  The end of sequence entry is always written.
+ */
+epicsUInt32 SoftSequence::writeRAM(SeqHW *target, const words_t& words)
+{
+    volatile epicsUInt32 *ram = static_cast<volatile epicsUInt32 *>(target->rambase);
+    epicsUInt32 *image = &target->image[0];
+    const size_t N = std::min(words.size(), target->image.size());
+    epicsUInt32 nwritten = 0;
+
+    for(size_t i=0; i<N; i++)
+    {
+        if(i+2>=N || i>=target->image_valid || image[i]!=words[i]) {
+            nat_iowrite32(ram+i, words[i]);
+            image[i] = words[i];
+            nwritten++;
+        }
+    }
+
+    // RAM beyond the end of sequence is left unchanged
+    target->image_valid = std::max(target->image_valid, N);
+
+    return nwritten;
+}
+
+// Called from ISR context, or with interruptLock
+void SoftSequence::swapHW()
+{
+    SeqHW *old = hw;
+
+    // old is already disarmed and not running
+    owner->mapTriggerSrc(old->idx, 0x02000000);
+
+    hw = standby;
+    standby = old;
+    std::swap(hw_seg, standby_seg);
+
     {
         epicsUInt32 ctrl = hw->ctrlreg_hw = hw->ctrlreg_user;
         if(is_enabled)
@@ -675,12 +972,125 @@ void SoftSequence::sync()
         else
             ctrl |= EVG_SEQ_RAM_DISABLE; // paranoia
 
-        DEBUG(3, ("  SeqCtrl %x\n", ctrl));
+        DEBUG(3, ("  Swap to %u SeqCtrl %x\n", hw->idx, ctrl));
         nat_iowrite32(hw->ctrlreg, ctrl);
     }
 
+    swap_pending = false;
     is_insync = true;
-    DEBUG(3, ("In Sync\n") );
+    numSwap++;
+
+    if(isStreaming())
+        callbackRequest(&refill_cb);
+
+    scanIoRequest(changed);
+}
+
+// Called from ISR context at the end of a segment when streaming.
+// Start the following segment, or with restart, ready the first for the next trigger.
+void SoftSequence::nextSegment(bool restart)
+{
+    const size_t next = restart ? 0u : hw_seg+1;
+
+    if(next==hw_seg) {
+        // stopped in the first segment, which is still loaded
+        epicsUInt32 ctrl = hw->ctrlreg_hw = hw->ctrlreg_user;
+        nat_iowrite32(hw->ctrlreg, ctrl | (is_enabled ? EVG_SEQ_RAM_ARM : EVG_SEQ_RAM_DISABLE));
+        return;
+    }
+
+    if(standby_seg!=next) {
+        // refill() not done in time.  Start over from the first segment.
+        if(!restart) {
+            numUnderrun++;
+            scanIoRequest(onErr);
+        }
+        is_insync = false;
+        sync();
+        return;
+    }
+
+    SeqHW *old = hw;
+
+    // old may have re-armed (Normal mode)
+    old->disarm();
+    owner->mapTriggerSrc(old->idx, 0x02000000);
+
+    hw = standby;
+    standby = old;
+    std::swap(hw_seg, standby_seg);
+
+    if(next) {
+        // continue immediately
+        owner->mapTriggerSrc(hw->idx, 0x02000000);
+        epicsUInt32 ctrl = hw->ctrlreg_hw = (hw->ctrlreg_user & ~(EVG_SEQ_RAM_REPEAT_MASK|EVG_SEQ_RAM_SRC_MASK))
+                | EVG_SEQ_RAM_SINGLE | hw->swTrigSrc();
+
+        DEBUG(3, ("  Chain to %u segment %u SeqCtrl %x\n", hw->idx, (unsigned)next, ctrl));
+        nat_iowrite32(hw->ctrlreg, ctrl | EVG_SEQ_RAM_ARM);
+        nat_iowrite32(hw->ctrlreg, ctrl | EVG_SEQ_RAM_SW_TRIG);
+
+    } else if(configCtrl(hw)) {
+        // wait for trigger
+        epicsUInt32 ctrl = hw->ctrlreg_hw = hw->ctrlreg_user;
+        nat_iowrite32(hw->ctrlreg, ctrl | (is_enabled ? EVG_SEQ_RAM_ARM : EVG_SEQ_RAM_DISABLE));
+    }
+
+    callbackRequest(&refill_cb);
+}
+
+void SoftSequence::refill()
+{
+    SCOPED_LOCK(mutex);
+
+    while(true) {
+        SeqHW *target;
+        size_t want;
+        epicsUInt32 nunder;
+        {
+            interruptLock L;
+            nunder = numUnderrun;
+            if(!isStreaming())
+                break;
+            want = (hw_seg+1)%committed.segs.size();
+            if(standby_seg==want)
+                break;
+            // nextSegment() won't use standby until standby_seg is set.
+            // commit() is excluded by our mutex
+            target = standby;
+            standby_seg = noSeg;
+        }
+
+        // committed is only changed with our mutex held
+        epicsUInt32 nwritten = writeRAM(target, committed.segs[want]);
+        DEBUG(3, ("Refill %u with segment %u, %u words\n", target->idx, (unsigned)want, (unsigned)nwritten));
+
+        {
+            interruptLock L;
+            numWritten = nwritten;
+            if(target==standby)
+                standby_seg = want;
+        }
+
+        if(nunder!=lastUnderrun) {
+            lastUnderrun = nunder;
+            last_err = "Next segment not ready.  Sequence restarted";
+            scanIoRequest(onErr);
+        }
+    }
+    scanIoRequest(changed);
+}
+
+void SoftSequence::refillCB(CALLBACK *cb)
+{
+    void *raw;
+    callbackGetUser(raw, cb);
+    SoftSequence *self = static_cast<SoftSequence*>(raw);
+    try {
+        self->refill();
+    } catch(std::exception& e) {
+        errlogPrintf("%s: refill error: %s\n", self->name().c_str(), e.what());
+    }
 }
 
 
@@ -730,6 +1140,10 @@ void SeqManager::doStartOfSequence(unsigned i)
 
     if(!seq) return;
 
+    // count the first segment only
+    if(seq->isStreaming() && seq->hw==HW && seq->hw_seg!=0)
+        return;
+
     seq->numStart++;
 
     scanIoRequest(seq->onStart);
@@ -747,6 +1161,14 @@ void SeqManager::doEndOfSequence(unsigned i)
 
     if(!seq) return;
 
+    if(seq->hw==HW && !seq->swap_pending && seq->isStreaming()
+            && seq->hw_seg+1<seq->committed.segs.size())
+    {
+        // more segments to go, unless disabled meanwhile
+        seq->nextSegment(!seq->is_enabled);
+        return;
+    }
+
     if(seq->committed.mode==Single) {
         seq->is_enabled = false;
     }
@@ -755,8 +1177,13 @@ void SeqManager::doEndOfSequence(unsigned i)
 
     scanIoRequest(seq->onEnd);
 
-    if(!seq->is_insync)
+    if(seq->swap_pending) {
+        if(seq->hw==HW)
+            seq->swapHW();
+    } else if(!seq->is_insync)
         seq->sync();
+    else if(seq->hw==HW && seq->isStreaming())
+        seq->nextSegment(true); // back to the first segment
 
     if(seq->committed.mode==Single)
         scanIoRequest(seq->changed);
@@ -10,6 +10,7 @@
 #include <map>
 #include <string>
 
+#include <epicsTypes.h>
 #include <dbScan.h>
 #include <shareLib.h>
 
@@ -44,6 +45,23 @@ public:
 
     static mrf::Object* buildSW(const std::string& name, const std::string& klass, const mrf::Object::create_args_t& args);
 
+    //! # of (time, code) entries in each HW sequencer RAM
+    enum {RAMLen=2048};
+
+    //! Sequence RAM content.  interleaved time and code words
+    typedef std::vector<epicsUInt32> words_t;
+    typedef std::vector<words_t> segments_t;
+
+    /** Split a sequence into RAM sized segments, each ending with 0x7f.
+     *
+     @param times Absolute times in ticks.  Increasing.
+     @param codes Event codes.  Must end with 0x7f.
+     @param segs Filled with at least one segment of at most RAMLen entries.
+     */
+    static void buildSegments(const std::vector<epicsUInt64>& times,
+                              const std::vector<epicsUInt8>& codes,
+                              segments_t& segs);
+
     //! Call from ISR
     void doStartOfSequence(unsigned i);
     //! Call from ISR
@@ -0,0 +1,104 @@
+/*************************************************************************\
+* mrfioc2 is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+#define epicsExportSharedSymbols
+#include "mrmSeqSim.h"
+
+namespace {
+// Control register bits, as mrmSeq.cpp
+const epicsUInt32 seqRunning   = 0x02000000;
+const epicsUInt32 seqEnabled   = 0x01000000;
+const epicsUInt32 seqSWTrig    = 0x00200000;
+const epicsUInt32 seqReset     = 0x00040000;
+const epicsUInt32 seqDisable   = 0x00020000;
+const epicsUInt32 seqArm       = 0x00010000;
+const epicsUInt32 seqWritable  = 0x00ffffff;
+const epicsUInt32 seqModeMask  = 0x00180000;
+const epicsUInt32 seqSingle    = 0x00100000;
+const epicsUInt32 seqRecycle   = 0x00080000;
+const epicsUInt32 seqSrcMask   = 0x000000ff;
+
+const size_t seqLen = 2048; // RAM entries
+}
+
+SeqSim::SeqSim(epicsUInt32 *ctrl, const epicsUInt32 *ram, epicsUInt8 srcDisable)
+    :ctrl(ctrl)
+    ,ram(ram)
+    ,srcDisable(srcDisable)
+    ,enabled(false)
+    ,running(false)
+    ,pos(0)
+    ,zero(0.0)
+{}
+
+void SeqSim::start(double at)
+{
+    running = true;
+    pos = 0;
+    zero = at;
+}
+
+epicsUInt32 SeqSim::readCtrl() const
+{
+    return *ctrl
+            | (enabled ? seqEnabled : 0)
+            | (running ? seqRunning : 0);
+}
+
+unsigned SeqSim::writeCtrl(epicsUInt32 val, double now)
+{
+    if(val&seqReset) {
+        running = false;
+        pos = 0;
+    }
+    if(val&seqDisable)
+        enabled = running = false;
+    if(val&seqArm)
+        enabled = true;
+    // action bits are write only
+    *ctrl = val&seqWritable&~(seqSWTrig|seqReset|seqDisable|seqArm);
+
+    if((val&seqSWTrig) && enabled && !running && (val&seqSrcMask)!=srcDisable) {
+        start(now);
+        return Started;
+    }
+    return 0;
+}
+
+bool SeqSim::next(double clk, double& at) const
+{
+    if(!running || clk<=0.0)
+        return false;
+    at = zero + ram[2*pos]/clk;
+    return true;
+}
+
+unsigned SeqSim::step(double clk, double at, epicsUInt8 *code)
+{
+    const epicsUInt32 T = ram[2*pos],
+                      C = ram[2*pos+1]&0xff;
+    *code = 0;
+
+    pos++;
+    if(T==0xffffffff) // counter rolls over
+        zero += 4294967296.0/clk;
+
+    if(C!=0x7f && pos<seqLen) {
+        *code = epicsUInt8(C);
+        return 0;
+    }
+
+    running = false;
+
+    switch(*ctrl&seqModeMask) {
+    case seqSingle:
+        enabled = false;
+        break;
+    case seqRecycle:
+        start(at);
+        return Ended|Started;
+    }
+    return Ended;
+}
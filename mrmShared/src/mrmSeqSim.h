@@ -0,0 +1,57 @@
+/*************************************************************************\
+* mrfioc2 is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+#ifndef MRMSEQSIM_H
+#define MRMSEQSIM_H
+
+#include <stddef.h>
+
+#include <epicsTypes.h>
+#include <shareLib.h>
+
+/** @brief Sequencer model for simulated EVRs and EVGs
+ *
+ * Plays the entries of one sequence RAM in host memory.
+ * Times are in seconds, from any fixed reference chosen by the owner.
+ * Only software triggers are simulated.
+ * Not thread safe.  The owner serializes all calls.
+ */
+class epicsShareClass SeqSim
+{
+    epicsUInt32 * const ctrl;
+    const epicsUInt32 * const ram;
+    const epicsUInt8 srcDisable;
+
+    bool enabled, running;
+    size_t pos;  // next RAM entry
+    double zero; // when the sequence counter was zero
+
+    void start(double at);
+public:
+    //! returned by writeCtrl() and step()
+    enum {
+        Started = 1, //!< start of sequence
+        Ended   = 2  //!< end of sequence
+    };
+
+    /** @param ctrl Storage of the control register
+     *  @param ram  Sequence RAM.  Pairs of time and event code words.
+     *  @param srcDisable Trigger source code for disabled (EVG 31, EVR 63)
+     */
+    SeqSim(epicsUInt32 *ctrl, const epicsUInt32 *ram, epicsUInt8 srcDisable);
+
+    //! Value of the control register, with the status bits
+    epicsUInt32 readCtrl() const;
+    //! Write the control register.  now is the current time.
+    //! @returns Started if software triggered
+    unsigned writeCtrl(epicsUInt32 val, double now);
+
+    //! Time of the next RAM entry.  false when not running.  clk is the event clock (Hz)
+    bool next(double clk, double& at) const;
+    //! Play the entry found by next().  Stores the event code to send, or 0, through code.
+    //! @returns Started and/or Ended (recycle mode)
+    unsigned step(double clk, double at, epicsUInt8 *code);
+};
+
+#endif // MRMSEQSIM_H
@@ -0,0 +1,128 @@
+#include <vector>
+
+#include "epicsUnitTest.h"
+#include "testMain.h"
+
+#include "mrmSeq.h"
+
+namespace {
+
+typedef std::vector<epicsUInt64> times_t;
+typedef std::vector<epicsUInt8> codes_t;
+
+const epicsUInt64 rollover = epicsUInt64(1u)<<32;
+
+// every segment fits in RAM and ends with 0x7f
+bool checkShape(const SeqManager::segments_t& segs)
+{
+    for(size_t i=0; i<segs.size(); i++) {
+        const SeqManager::words_t& W = segs[i];
+        if(W.size()<2 || W.size()>2*SeqManager::RAMLen || W.size()%2 || W.back()!=0x7f) {
+            testDiag("segment %u has %u words, last code 0x%x", (unsigned)i,
+                     (unsigned)W.size(), W.empty() ? 0u : (unsigned)W.back());
+            return false;
+        }
+    }
+    return true;
+}
+
+void testShort()
+{
+    testDiag("testShort()");
+    times_t T;
+    codes_t C;
+    T.push_back(10); C.push_back(1);
+    T.push_back(20); C.push_back(2);
+    T.push_back(21); C.push_back(0x7f);
+
+    SeqManager::segments_t segs;
+    SeqManager::buildSegments(T, C, segs);
+
+    testOk1(segs.size()==1);
+    testOk1(checkShape(segs));
+    testOk1(segs[0].size()==6 && segs[0][0]==10 && segs[0][1]==1 && segs[0][4]==21);
+}
+
+void testRollover()
+{
+    testDiag("testRollover()");
+    times_t T;
+    codes_t C;
+    T.push_back(10); C.push_back(1);
+    T.push_back(rollover+5); C.push_back(2);
+    T.push_back(rollover+6); C.push_back(0x7f);
+
+    SeqManager::segments_t segs;
+    SeqManager::buildSegments(T, C, segs);
+
+    testOk1(segs.size()==1);
+    testOk1(checkShape(segs));
+    // 10, rollover, 5, 6
+    testOk1(segs[0].size()==8);
+    testOk1(segs[0][2]==0xffffffff && segs[0][3]==0);
+    testOk1(segs[0][4]==5 && segs[0][5]==2);
+}
+
+void testSplit()
+{
+    testDiag("testSplit()");
+    times_t T;
+    codes_t C;
+    for(unsigned i=0; i<3000; i++) {
+        T.push_back(1+i);
+        C.push_back(1);
+    }
+    T.push_back(T.back()+1); C.push_back(0x7f);
+
+    SeqManager::segments_t segs;
+    SeqManager::buildSegments(T, C, segs);
+
+    testOk1(segs.size()==2);
+    testOk1(checkShape(segs));
+    testOk1(segs[0].size()==2*SeqManager::RAMLen);
+}
+
+// A full segment, and the end of sequence needs a rollover first.
+void testRolloverAtEnd()
+{
+    testDiag("testRolloverAtEnd()");
+    times_t T;
+    codes_t C;
+    for(unsigned i=0; i<SeqManager::RAMLen-1; i++) {
+        T.push_back(1+i);
+        C.push_back(1);
+    }
+    T.push_back(rollover+100); C.push_back(0x7f);
+
+    SeqManager::segments_t segs;
+    SeqManager::buildSegments(T, C, segs);
+
+    testOk1(checkShape(segs));
+    testOk1(segs.size()==2);
+    if(segs.size()==2) {
+        const SeqManager::words_t& last = segs[1];
+        // ends at rollover+100 in absolute time
+        epicsUInt64 base = SeqManager::RAMLen; // one tick after entry 2047
+        epicsUInt64 zero = base, t = 0;
+        for(size_t i=0; i<last.size(); i+=2) {
+            t = zero+last[i];
+            if(last[i]==0xffffffff)
+                zero += rollover;
+        }
+        testOk(t==rollover+100, "end at %llu", (unsigned long long)t);
+    } else {
+        testSkip(1, "wrong # of segments");
+    }
+}
+
+} // namespace
+
+MAIN(mrmSeqTest)
+{
+    testPlan(14);
+    testShort();
+    testRollover();
+    testSplit();
+    testRolloverAtEnd();
+    return testDone();
+}